@@ -0,0 +1,369 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <list>
+#include <string>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <numeric>
+#include <algorithm>
+#include <random>
+#include <async.h>
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_for_each.h>
+#include <tbb/blocked_range.h>
+#include <tbb/task_arena.h>
+#if __has_include(<execution>)
+	#include <execution>
+#endif
+#ifdef _OPENMP
+	#include <omp.h>
+#endif
+
+// Copyright (c) 2025  Constantine Papakonstantinou
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// Benchmark sweep of async_for_each against serial std::for_each, tbb::parallel_for,
+// OpenMP and std::for_each(std::execution::par) over sizes, thread counts, element
+// costs and iterator categories. Each row reports the median ns per element, the
+// speedup over the serial loop and the scaling efficiency (speedup / threads).
+//
+//	async_bench [--min-size N] [--max-size N] [--threads 1,2,4] [--min-time SECONDS]
+//	            [--list-max-size N] [--filter SUBSTRING] [--csv]
+
+#if defined(__cpp_lib_parallel_algorithm) && __has_include(<execution>)
+	#define BENCH_STD_PAR 1
+#else
+	#define BENCH_STD_PAR 0
+#endif
+
+using clock_type = std::chrono::steady_clock;
+
+struct options
+{
+	size_t min_size = 100;
+	size_t max_size = 10000000;
+	size_t list_max_size = 1000000;
+	std::vector<size_t> threads;
+	double min_time = 0.05;
+	std::string filter;
+	bool csv = false;
+};
+
+// Inputs shared by the workloads, sized by `prepare`.
+static std::vector<double> source;
+static std::vector<size_t> gather;
+static size_t current_size = 0;
+
+static inline void trivial(double& x, size_t) { x = x * 1.000001 + 1.0; }
+
+static inline void compute(double& x, size_t i)
+{
+	double v = static_cast<double>(i);
+	for (int k = 0; k < 16; ++k)
+		v = std::sin(v) + 1.0;
+	x = v;
+}
+
+// Random gather from an array larger than the caches.
+static inline void memory(double& x, size_t i) { x = source[gather[i]]; }
+
+// Cost clustered at the end of the range: the last eighth is 64x as expensive.
+static inline void irregular(double& x, size_t i)
+{
+	int rounds = i >= current_size - current_size / 8 ? 256 : 4;
+	double v = static_cast<double>(i);
+	for (int k = 0; k < rounds; ++k)
+		v = std::sqrt(v + k);
+	x = v;
+}
+
+/// Per-element work of one benchmark: `op(x, i)` updates element `x` at index `i`.
+using element_op = void (*)(double&, size_t);
+
+struct kernel
+{
+	std::string name;
+	element_op op;
+	bool list;
+};
+
+/**
+ * \brief Median wall time of `run()` in seconds, repeated until `min_time` has passed (at least 3 runs).
+ */
+template<typename R>
+double measure(R&& run, double min_time)
+{
+	run(); // warm up caches, pools and arenas
+
+	std::vector<double> samples;
+	double total = 0.0;
+	while (samples.size() < 3 || total < min_time)
+	{
+		auto start = clock_type::now();
+		run();
+		double elapsed = std::chrono::duration<double>(clock_type::now() - start).count();
+		samples.push_back(elapsed);
+		total += elapsed;
+		if (samples.size() >= 1000) break;
+	}
+	std::sort(samples.begin(), samples.end());
+	return samples[samples.size() / 2];
+}
+
+static void print_header(const options& opt)
+{
+	if (opt.csv)
+	{
+		std::cout << "workload,container,size,impl,threads,ns_per_element,speedup,efficiency\n";
+		return;
+	}
+	std::cout << std::left << std::setw(11) << "workload" << std::setw(8) << "cont"
+		<< std::right << std::setw(12) << "size" << "  " << std::left << std::setw(14) << "impl"
+		<< std::right << std::setw(8) << "threads" << std::setw(14) << "ns/elem"
+		<< std::setw(10) << "speedup" << std::setw(12) << "efficiency" << "\n";
+}
+
+static void print_row(const options& opt, const std::string& work, const std::string& container, size_t size,
+	const std::string& impl, size_t threads, double seconds, double serial_seconds)
+{
+	double ns = seconds * 1e9 / static_cast<double>(size);
+	double speedup = serial_seconds / seconds;
+	double efficiency = speedup / static_cast<double>(threads);
+
+	if (opt.csv)
+	{
+		std::cout << work << "," << container << "," << size << "," << impl << "," << threads << ","
+			<< ns << "," << speedup << "," << efficiency << "\n";
+		return;
+	}
+	std::cout << std::left << std::setw(11) << work << std::setw(8) << container
+		<< std::right << std::setw(12) << size << "  " << std::left << std::setw(14) << impl
+		<< std::right << std::setw(8) << threads << std::fixed << std::setprecision(3)
+		<< std::setw(14) << ns << std::setw(10) << speedup << std::setw(12) << efficiency << "\n";
+	std::cout.unsetf(std::ios::fixed);
+}
+
+static void prepare(size_t size)
+{
+	current_size = size;
+	source.assign(size, 1.0);
+	std::iota(source.begin(), source.end(), 0.0);
+	gather.resize(size);
+	std::iota(gather.begin(), gather.end(), 0);
+	std::shuffle(gather.begin(), gather.end(), std::mt19937_64(42));
+}
+
+static void bench_vector(const options& opt, const kernel& k, size_t size)
+{
+	std::vector<double> data(size, 1.0);
+	const element_op op = k.op;
+
+	double serial = measure([&]
+	{
+		size_t i = 0;
+		std::for_each(data.begin(), data.end(), [&](double& x) { op(x, i++); });
+	}, opt.min_time);
+	print_row(opt, k.name, "vector", size, "serial", 1, serial, serial);
+
+	for (size_t t : opt.threads)
+	{
+		double a = measure([&]
+		{
+			async::async_for_each(data.begin(), data.end(), [op](double& x, size_t i) { op(x, i); }, t);
+		}, opt.min_time);
+		print_row(opt, k.name, "vector", size, "async", t, a, serial);
+
+		double g = measure([&]
+		{
+			async::async_for_each(async::guided_partitioner{}, data.begin(), data.end(),
+				[op](double& x, size_t i) { op(x, i); }, t);
+		}, opt.min_time);
+		print_row(opt, k.name, "vector", size, "async_guided", t, g, serial);
+
+		tbb::task_arena arena(static_cast<int>(t));
+		double b = measure([&]
+		{
+			arena.execute([&]
+			{
+				tbb::parallel_for(tbb::blocked_range<size_t>(0, size), [&](const tbb::blocked_range<size_t>& r)
+				{
+					for (size_t i = r.begin(); i != r.end(); ++i)
+						op(data[i], i);
+				});
+			});
+		}, opt.min_time);
+		print_row(opt, k.name, "vector", size, "tbb", t, b, serial);
+
+#ifdef _OPENMP
+		double o = measure([&]
+		{
+			double* p = data.data();
+			#pragma omp parallel for num_threads(t) schedule(static)
+			for (size_t i = 0; i < size; ++i)
+				op(p[i], i);
+		}, opt.min_time);
+		print_row(opt, k.name, "vector", size, "openmp", t, o, serial);
+#endif
+	}
+
+#if BENCH_STD_PAR
+	// The standard policies do not take a thread count; report them at the widest setting.
+	double s = measure([&]
+	{
+		double* base = data.data();
+		std::for_each(std::execution::par, data.begin(), data.end(),
+			[op, base](double& x) { op(x, static_cast<size_t>(&x - base)); });
+	}, opt.min_time);
+	print_row(opt, k.name, "vector", size, "std_par", opt.threads.back(), s, serial);
+#endif
+}
+
+static void bench_list(const options& opt, const kernel& k, size_t size)
+{
+	std::list<double> data(size, 1.0);
+	const element_op op = k.op;
+
+	double serial = measure([&]
+	{
+		size_t i = 0;
+		for (double& x : data)
+			op(x, i++);
+	}, opt.min_time);
+	print_row(opt, k.name, "list", size, "serial", 1, serial, serial);
+
+	for (size_t t : opt.threads)
+	{
+		double a = measure([&]
+		{
+			async::async_for_each(data.begin(), data.end(), [op](double& x, size_t i) { op(x, i); }, t);
+		}, opt.min_time);
+		print_row(opt, k.name, "list", size, "async", t, a, serial);
+
+		tbb::task_arena arena(static_cast<int>(t));
+		double b = measure([&]
+		{
+			arena.execute([&]
+			{
+				tbb::parallel_for_each(data.begin(), data.end(), [op](double& x) { op(x, 0); });
+			});
+		}, opt.min_time);
+		print_row(opt, k.name, "list", size, "tbb", t, b, serial);
+	}
+
+#if BENCH_STD_PAR
+	double s = measure([&]
+	{
+		std::for_each(std::execution::par, data.begin(), data.end(), [op](double& x) { op(x, 0); });
+	}, opt.min_time);
+	print_row(opt, k.name, "list", size, "std_par", opt.threads.back(), s, serial);
+#endif
+}
+
+static size_t parse_size(const char* text)
+{
+	return static_cast<size_t>(std::strtod(text, nullptr)); // accepts 1e9
+}
+
+static options parse(int argc, char* argv[])
+{
+	options opt;
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+		auto value = [&]() -> const char*
+		{
+			if (i + 1 >= argc)
+			{
+				std::cerr << "missing value for " << arg << "\n";
+				std::exit(1);
+			}
+			return argv[++i];
+		};
+
+		if (arg == "--min-size") opt.min_size = std::max<size_t>(1, parse_size(value())); // the size loop multiplies
+		else if (arg == "--max-size") opt.max_size = parse_size(value());
+		else if (arg == "--list-max-size") opt.list_max_size = parse_size(value());
+		else if (arg == "--min-time") opt.min_time = std::strtod(value(), nullptr);
+		else if (arg == "--filter") opt.filter = value();
+		else if (arg == "--csv") opt.csv = true;
+		else if (arg == "--threads")
+		{
+			std::string list = value();
+			for (size_t pos = 0; pos < list.size();)
+			{
+				size_t comma = list.find(',', pos);
+				if (comma == std::string::npos) comma = list.size();
+				opt.threads.push_back(std::max<size_t>(1, std::stoul(list.substr(pos, comma - pos))));
+				pos = comma + 1;
+			}
+		}
+		else
+		{
+			std::cerr << "usage: " << argv[0] << " [--min-size N] [--max-size N] [--threads 1,2,4] "
+				"[--min-time SECONDS] [--list-max-size N] [--filter SUBSTRING] [--csv]\n";
+			std::exit(arg == "--help" ? 0 : 1);
+		}
+	}
+
+	if (opt.threads.empty())
+	{
+		// Powers of two up to the pool size, and the pool size itself.
+		size_t pool = async::runtime_threads();
+		for (size_t t = 1; t < pool; t *= 2)
+			opt.threads.push_back(t);
+		opt.threads.push_back(pool);
+	}
+	return opt;
+}
+
+int main(int argc, char* argv[])
+{
+	options opt = parse(argc, argv);
+
+	const std::vector<kernel> kernels =
+	{
+		{"trivial", trivial, true},
+		{"compute", compute, true},
+		{"memory", memory, false},
+		{"irregular", irregular, false},
+	};
+
+	std::cout << "# pool threads: " << async::runtime_threads()
+		<< ", hardware threads: " << std::thread::hardware_concurrency() << "\n";
+	print_header(opt);
+
+	for (const auto& k : kernels)
+	{
+		if (!opt.filter.empty() && k.name.find(opt.filter) == std::string::npos) continue;
+
+		for (size_t size = opt.min_size; size <= opt.max_size; size *= 10)
+		{
+			prepare(size);
+			bench_vector(opt, k, size);
+			if (k.list && size <= opt.list_max_size)
+				bench_list(opt, k, size);
+		}
+	}
+
+	return 0;
+}
@@ -31,14 +31,34 @@
 #include <future>
 #include <thread>
 #include <mutex>
+#include <stop_token>
+#include <condition_variable>
+#include <functional>
+#include <deque>
+#include <chrono>
 #include <vector>
+#include <array>
+#include <optional>
+#include <span>
+#include <memory>
+#include <coroutine>
 #include <atomic>
 #include <concepts>
+#include <bit>
+#include <cstddef>
 #include <ranges>
 #include <algorithm>
 #include <exception>
+#include <stdexcept>
 #include <type_traits>
+#include <utility>
+#include <tuple>
 #include <iterator>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <cstdlib>
+#include <cstdint>
 
 #ifdef __linux__
 	#include <pthread.h>
@@ -50,6 +70,14 @@ namespace async
 	// Recommend the number of real cores, for thread pinning.
 	#ifndef ASYNC_NUM_THREADS
 		#define ASYNC_NUM_THREADS 4  // default value
+		#ifndef ASYNC_AUTO_THREADS
+			#define ASYNC_AUTO_THREADS 1  // size the pool from the CPU quota unless a count is given
+		#endif
+	#endif
+
+	// Default the runtime thread count to `available_concurrency()` instead of ASYNC_NUM_THREADS.
+	#ifndef ASYNC_AUTO_THREADS
+		#define ASYNC_AUTO_THREADS 0  // default value
 	#endif
 	
 	#ifndef ASYNC_MIN_THREADS
@@ -60,193 +88,5374 @@ namespace async
 		#define ASYNC_MAX_THREADS 64  // default value
 	#endif
 
-	static constexpr size_t threads = ASYNC_NUM_THREADS; ///< Number of threads to use.
+	// Minimum elements per thread; 1 splits any range across every thread.
+	#ifndef ASYNC_MIN_GRAIN
+		#define ASYNC_MIN_GRAIN 1  // default value
+	#endif
+
+	// Estimated cost of dispatching one task, used by the adaptive partitioner.
+	#ifndef ASYNC_TASK_OVERHEAD_NS
+		#define ASYNC_TASK_OVERHEAD_NS 5000  // default value
+	#endif
+
+	// Polls of the completion counter before a joining thread parks.
+	#ifndef ASYNC_JOIN_SPIN
+		#define ASYNC_JOIN_SPIN 2048  // default value
+	#endif
+
+	// Record per-call instrumentation into `async::stats`; compiled out when 0.
+	#ifndef ASYNC_STATS
+		#define ASYNC_STATS 0  // default value
+	#endif
+
+	static constexpr size_t threads = ASYNC_NUM_THREADS; ///< Number of threads to use.
+
+	namespace detail
+	{
+		/// CPUs granted by a CFS quota over period, rounded up; 0 if unlimited or invalid.
+		inline size_t quota_cpus(long long quota, long long period) noexcept
+		{
+			if (quota <= 0 || period <= 0) return 0;
+			return static_cast<size_t>((quota + period - 1) / period);
+		}
+
+		/// Quota in CPUs read from the cgroup directory `dir`, v2 `cpu.max` or v1 `cpu.cfs_*`; 0 if none.
+		inline size_t cgroup_dir_quota(const std::string& dir, bool v2)
+		{
+			long long quota = 0, period = 0;
+			if (v2)
+			{
+				std::ifstream max(dir + "/cpu.max");
+				std::string limit;
+				if (!(max >> limit >> period) || limit == "max") return 0;
+				quota = std::atoll(limit.c_str());
+			}
+			else
+			{
+				std::ifstream cfs_quota(dir + "/cpu.cfs_quota_us");
+				std::ifstream cfs_period(dir + "/cpu.cfs_period_us");
+				if (!(cfs_quota >> quota && cfs_period >> period)) return 0;
+			}
+			return quota_cpus(quota, period);
+		}
+
+		/**
+		 * \brief Tightest CPU quota over the process's cgroup and its ancestors, 0 if there is none.
+		 *
+		 * Resolves the process's v2 cgroup and its v1 `cpu` cgroup from `<proc>/cgroup`
+		 * against the cgroup mounts in `<proc>/mountinfo`, then walks each from the
+		 * leaf up to the mount root, taking the minimum of quota over period. In a
+		 * container the mount root is the container's own cgroup, whose limit is
+		 * usually the one that applies. `proc` is only overridden by the tests.
+		 */
+		inline size_t cgroup_quota(const std::string& proc = "/proc/self")
+		{
+			auto split = [](const std::string& text, char sep)
+			{
+				std::vector<std::string> parts;
+				std::stringstream stream(text);
+				for (std::string part; std::getline(stream, part, sep);)
+					parts.push_back(part);
+				return parts;
+			};
+
+			// "0::<path>" for v2; "<id>:<controllers>:<path>" for v1.
+			std::optional<std::string> v2_path, cpu_path;
+			{
+				std::ifstream cgroup(proc + "/cgroup");
+				for (std::string line; std::getline(cgroup, line);)
+				{
+					auto first = line.find(':'), second = line.find(':', first + 1);
+					if (first == std::string::npos || second == std::string::npos) continue;
+					std::string controllers = line.substr(first + 1, second - first - 1);
+					std::string path = line.substr(second + 1);
+					if (line.compare(0, first, "0") == 0 && controllers.empty())
+						v2_path = path;
+					else if (std::ranges::count(split(controllers, ','), std::string("cpu")) != 0)
+						cpu_path = path;
+				}
+			}
+
+			size_t quota = 0;
+			std::ifstream mountinfo(proc + "/mountinfo");
+			for (std::string line; std::getline(mountinfo, line);)
+			{
+				// "<id> <parent> <dev> <root> <mount point> <options> [optional...] - <type> <source> <super options>"
+				auto fields = split(line, ' ');
+				auto sep = std::ranges::find(fields, std::string("-"));
+				if (fields.size() < 5 || std::distance(sep, fields.end()) < 4) continue;
+
+				const std::string& type = sep[1];
+				bool v2 = type == "cgroup2";
+				if (!v2 && !(type == "cgroup" && std::ranges::count(split(sep[3], ','), std::string("cpu")) != 0))
+					continue;
+				const auto& path = v2 ? v2_path : cpu_path;
+				if (!path) continue;
+
+				// The mount exposes the hierarchy from `root`; the cgroup lies below it.
+				const std::string& root = fields[3];
+				const std::string& mount = fields[4];
+				std::string dir = mount;
+				if (root == "/")
+					dir += *path;
+				else if (path->compare(0, root.size(), root) == 0)
+					dir += path->substr(root.size());
+				while (dir.size() > mount.size() && dir.back() == '/')
+					dir.pop_back();
+
+				for (;;)
+				{
+					size_t limit = cgroup_dir_quota(dir, v2);
+					if (limit != 0 && (quota == 0 || limit < quota))
+						quota = limit;
+					if (dir.size() <= mount.size()) break;
+					dir.erase(std::max(dir.rfind('/'), mount.size()));
+				}
+			}
+			return quota;
+		}
+	}
+
+	/**
+	 * \brief Number of CPUs this process may use: its affinity mask, capped by any cgroup CPU quota.
+	 *
+	 * Reads `sched_getaffinity` and the tightest CFS quota on the path from the
+	 * process's cgroup to the root, from `cpu.max` (cgroup v2) or `cpu.cfs_quota_us` 
+	 * / `cpu.cfs_period_us` (v1), rounding a fractional quota up. Probed on every
+	 * call, which reads a few files under `/proc` and `/sys/fs/cgroup`, so a changed
+	 * quota is seen by the next call; keep it off hot paths. Falls back to
+	 * `std::thread::hardware_concurrency()`.
+	 */
+	inline size_t available_concurrency()
+	{
+		size_t cpus = std::max<size_t>(1, std::thread::hardware_concurrency());
+
+		#ifdef __linux__
+			cpu_set_t cpuset;
+			CPU_ZERO(&cpuset);
+			if (sched_getaffinity(0, sizeof(cpuset), &cpuset) == 0)
+				cpus = std::max(1, CPU_COUNT(&cpuset));
+
+			if (size_t quota = detail::cgroup_quota(); quota != 0)
+				cpus = std::min(cpus, quota);
+		#endif
+
+		return cpus;
+	}
+
+	namespace detail
+	{
+		inline size_t clamp_threads(size_t n) noexcept
+		{
+			return std::clamp<size_t>(n, ASYNC_MIN_THREADS, ASYNC_MAX_THREADS);
+		}
+
+		/// Thread count before any `set_concurrency()`: `ASYNC_NUM_THREADS` from the environment ("auto" allowed), else the build default.
+		inline size_t initial_concurrency()
+		{
+			const char* env_async = std::getenv("ASYNC_NUM_THREADS");
+			if (env_async && std::string(env_async) == "auto")
+				return clamp_threads(available_concurrency());
+			if (env_async)
+				return clamp_threads(static_cast<size_t>(std::max(1, std::atoi(env_async))));
+			return clamp_threads(ASYNC_AUTO_THREADS ? available_concurrency() : threads);
+		}
+
+		inline std::atomic<size_t>& concurrency_value() noexcept
+		{
+			static std::atomic<size_t> _threads{initial_concurrency()};
+			return _threads;
+		}
+	}
+
+	/** 
+	 * \brief Default number of participants of a parallel call, and the size of the pool.
+	 *
+	 * Initially the `ASYNC_NUM_THREADS` environment variable, a count or "auto"
+	 * for `available_concurrency()`, else the build default, clamped to 
+	 * `[ASYNC_MIN_THREADS, ASYNC_MAX_THREADS]`. Changed by `set_concurrency()`.
+	 */
+	inline size_t runtime_threads() 
+	{
+		return detail::concurrency_value().load(std::memory_order_relaxed);
+	}
+
+	namespace detail
+	{
+		inline std::atomic<size_t>& min_grain_value() noexcept
+		{
+			static std::atomic<size_t> _grain = []
+			{
+				const char* env_grain = std::getenv("ASYNC_MIN_GRAIN");
+				long grain = env_grain ? std::atol(env_grain) : ASYNC_MIN_GRAIN;
+				return static_cast<size_t>(std::max(1L, grain));
+			}();
+			return _grain;
+		}
+	}
+
+	/**
+	 * \brief Minimum number of elements per thread, `ASYNC_MIN_GRAIN` unless set by the environment variable of that name.
+	 *
+	 * A loop over `size` elements uses at most `size / min_grain()` threads, so 
+	 * ranges shorter than twice the grain run inline on the caller.
+	 */
+	inline size_t min_grain() noexcept 
+	{ 
+		return detail::min_grain_value().load(std::memory_order_relaxed); 
+	}
+
+	/// Set the minimum number of elements per thread for subsequent loops.
+	inline void set_min_grain(size_t grain) noexcept 
+	{ 
+		detail::min_grain_value().store(std::max<size_t>(1, grain), std::memory_order_relaxed); 
+	}
+
+	namespace detail
+	{
+		/// Threads to use for `size` elements: at most `threads`, and at least `min_grain()` elements each.
+		inline size_t cap_threads(size_t threads, size_t size) noexcept
+		{
+			return std::max<size_t>(1, std::min(threads, size / min_grain()));
+		}
+	}
+
+	/**
+	 * \brief Launch an asynchronous task using std::async with forwarded parameters.
+	 * \tparam F Callable type
+	 * \tparam Ts Argument types
+	 * \param f Callable to execute
+	 * \param params Arguments to pass to callable
+	 * \return std::future holding the result of the async operation
+	 */
+	template<typename F, typename... Ts> 
+	inline std::future<typename std::result_of<F(Ts...)>::type>
+	call_async(F&& f, Ts&&... params) 
+	{
+		return std::async(std::launch::async, 
+			std::forward<F>(f), 
+			std::forward<Ts>(params)...);
+	}
+
+	/// Trait for checking if an iterator is random access
+	template<typename I>
+	constexpr bool is_random_access_iterator_v = std::random_access_iterator<I>;
+
+	/**
+	 * \brief CPU and NUMA topology of the machine.
+	 *
+	 * On Linux, read once from `/sys/devices/system/node` and the CPU `topology`
+	 * directories; elsewhere, or when sysfs is unavailable, a single node holding
+	 * `hardware_concurrency()` CPUs.
+	 */
+	class topology
+	{
+	public:
+		/**
+		 * \brief Topology of the running machine, probed on first use.
+		 */
+		static const topology& instance()
+		{
+			static const topology _topology = probe();
+			return _topology;
+		}
+
+		/// Number of NUMA nodes.
+		size_t nodes() const noexcept { return _node_cpus.size(); }
+
+		/**
+		 * \brief CPUs of `node`, one hardware thread per physical core first, SMT siblings after.
+		 */
+		const std::vector<int>& cpus(size_t node) const { return _node_cpus[node]; }
+
+		/**
+		 * \brief NUMA node of `cpu`, 0 if unknown.
+		 */
+		size_t node_of(int cpu) const noexcept
+		{
+			for (size_t n = 0; n < _node_cpus.size(); ++n)
+				if (std::find(_node_cpus[n].begin(), _node_cpus[n].end(), cpu) != _node_cpus[n].end())
+					return n;
+			return 0;
+		}
+
+		/**
+		 * \brief All CPUs, spread across nodes: the k-th CPU of every node before the (k+1)-th of any.
+		 */
+		std::vector<int> scatter() const
+		{
+			std::vector<int> order;
+			for (size_t k = 0; order.size() < cpu_count(); ++k)
+				for (const auto& node : _node_cpus)
+					if (k < node.size())
+						order.push_back(node[k]);
+			return order;
+		}
+
+		/**
+		 * \brief CPUs the process may run on (`sched_getaffinity` at first use), ascending.
+		 */
+		const std::vector<int>& allowed() const noexcept { return _allowed; }
+
+		/// Total number of CPUs.
+		size_t cpu_count() const noexcept
+		{
+			size_t count = 0;
+			for (const auto& node : _node_cpus)
+				count += node.size();
+			return count;
+		}
+
+		/**
+		 * \brief Parse a sysfs CPU or node list such as `0-3,8-11`.
+		 */
+		static std::vector<int> parse_list(const std::string& list)
+		{
+			std::vector<int> ids;
+			std::stringstream ss(list);
+			std::string range;
+			while (std::getline(ss, range, ','))
+			{
+				if (range.empty() || range == "\n") continue;
+				auto dash = range.find('-');
+				int first = std::stoi(range.substr(0, dash));
+				int last = (dash == std::string::npos) ? first : std::stoi(range.substr(dash + 1));
+				for (int id = first; id <= last; ++id)
+					ids.push_back(id);
+			}
+			return ids;
+		}
+
+	private:
+		static std::string read_line(const std::string& path)
+		{
+			std::ifstream file(path);
+			std::string line;
+			std::getline(file, line);
+			return line;
+		}
+
+		static topology probe()
+		{
+			topology topo;
+
+			#ifdef __linux__
+				for (int node : parse_list(read_line("/sys/devices/system/node/online")))
+				{
+					std::vector<int> cores, siblings;
+					for (int cpu : parse_list(read_line("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist")))
+					{
+						auto smt = parse_list(read_line("/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/topology/thread_siblings_list"));
+						if (smt.empty() || smt.front() == cpu)
+							cores.push_back(cpu);
+						else
+							siblings.push_back(cpu);
+					}
+					cores.insert(cores.end(), siblings.begin(), siblings.end());
+					if (!cores.empty())
+						topo._node_cpus.push_back(std::move(cores));
+				}
+			#endif
+
+			if (topo._node_cpus.empty())
+			{
+				std::vector<int> all(std::max(1u, std::thread::hardware_concurrency()));
+				for (size_t cpu = 0; cpu < all.size(); ++cpu)
+					all[cpu] = static_cast<int>(cpu);
+				topo._node_cpus.push_back(std::move(all));
+			}
+
+			#ifdef __linux__
+				cpu_set_t cpuset;
+				CPU_ZERO(&cpuset);
+				if (sched_getaffinity(0, sizeof(cpu_set_t), &cpuset) == 0)
+					for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+						if (CPU_ISSET(cpu, &cpuset))
+							topo._allowed.push_back(cpu);
+			#endif
+
+			if (topo._allowed.empty())
+			{
+				for (const auto& node : topo._node_cpus)
+					topo._allowed.insert(topo._allowed.end(), node.begin(), node.end());
+				std::sort(topo._allowed.begin(), topo._allowed.end());
+			}
+			return topo;
+		}
+
+		std::vector<std::vector<int>> _node_cpus;
+		std::vector<int> _allowed;
+	};
+
+	/**
+	 * \brief Policy placing pool workers on CPUs.
+	 *
+	 * Only CPUs in the process cpuset, as reported by `sched_getaffinity`, are 
+	 * used, so several processes confined to disjoint cpusets (containers, 
+	 * `taskset`) do not pin onto the same cores.
+	 */
+	struct affinity
+	{
+		enum class policy
+		{
+			none,    ///< Not pinned: workers float over the process cpuset
+			compact, ///< Fill a node, physical cores before SMT siblings, before the next node
+			scatter, ///< Round-robin across nodes, physical cores before SMT siblings
+			list     ///< Worker `i` pinned to `cpus[i % cpus.size()]`
+		};
+
+		policy mode = policy::scatter;
+		std::vector<int> cpus; ///< CPUs for `policy::list`
+
+		/**
+		 * \brief Parse `none`, `compact`, `scatter` or a CPU list such as `0,2,4-7`.
+		 *
+		 * Anything unrecognised yields the default, `scatter`.
+		 */
+		static affinity parse(const std::string& spec)
+		{
+			if (spec == "none") return {policy::none, {}};
+			if (spec == "compact") return {policy::compact, {}};
+			if (spec == "scatter" || spec.empty()) return {policy::scatter, {}};
+			try
+			{
+				auto cpus = topology::parse_list(spec);
+				if (!cpus.empty()) return {policy::list, std::move(cpus)};
+			}
+			catch (...) {}
+			return {policy::scatter, {}};
+		}
+
+		/** 
+		 * \brief Policy from the `ASYNC_AFFINITY` environment variable, `scatter` if unset.
+		 */
+		static affinity from_env()
+		{
+			const char* env_affinity = std::getenv("ASYNC_AFFINITY");
+			return parse(env_affinity ? env_affinity : "");
+		}
+
+		/**
+		 * \brief CPU for each of `n` workers, -1 for a worker that is not pinned.
+		 */
+		std::vector<int> placement(size_t n) const
+		{
+			const auto& topo = topology::instance();
+			const auto& allowed = topo.allowed();
+			std::vector<int> order;
+
+			switch (mode)
+			{
+				case policy::none:
+					return std::vector<int>(n, -1);
+				case policy::list:
+					order = cpus;
+					break;
+				case policy::compact:
+					for (size_t node = 0; node < topo.nodes(); ++node)
+						order.insert(order.end(), topo.cpus(node).begin(), topo.cpus(node).end());
+					break;
+				case policy::scatter:
+					order = topo.scatter();
+					break;
+			}
+
+			std::erase_if(order, [&](int cpu) 
+			{ 
+				return !std::binary_search(allowed.begin(), allowed.end(), cpu); 
+			});
+			if (order.empty()) 
+				order = allowed;
+
+			std::vector<int> result(n);
+			for (size_t i = 0; i < n; ++i)
+				result[i] = order[i % order.size()];
+			return result;
+		}
+	};
+
+	/**
+	 * \brief How a parallel loop started from inside a pool worker is run.
+	 */
+	enum class nesting
+	{
+		shared, ///< Dispatch onto the same pool, ahead of queued outer work (the default)
+		serial  ///< Run inline on the calling worker
+	};
+
+	/**
+	 * \brief Scheduling class of a task submitted with `submit(priority, f)`.
+	 */
+	enum class priority
+	{
+		high,   ///< Latency-critical: taken before any other queued work
+		normal, ///< Same class as parallel loop chunks and plain `submit()`
+		low     ///< Background: taken only when no other work is queued
+	};
+
+	/// Number of classes in `priority`.
+	inline constexpr size_t priority_levels = 3;
+
+	class thread_pool;
+
+	template<typename R>
+	class task_future;
+
+	namespace detail
+	{
+		/// Identity of the calling thread within a pool, if it is a worker.
+		struct worker_identity
+		{
+			thread_pool* pool = nullptr;
+			size_t index = 0;
+		};
+
+		inline worker_identity& this_worker() noexcept
+		{
+			thread_local worker_identity _identity;
+			return _identity;
+		}
+
+		/// Hint to the CPU that the caller is spinning.
+		inline void cpu_relax() noexcept
+		{
+			#if defined(__x86_64__) || defined(__i386__)
+				__builtin_ia32_pause();
+			#elif defined(__aarch64__)
+				asm volatile("yield");
+			#endif
+		}
+
+		/// Value on its own cache line, for per-thread partial results.
+		template<typename T>
+		struct alignas(64) padded
+		{
+			T value;
+		};
+
+		/**
+		 * \brief Intrusive pool task, queued by pointer.
+		 *
+		 * The node is owned by whoever queued it and must outlive its execution;
+		 * `execute` is the last use of the node by the pool.
+		 */
+		struct task_node
+		{
+			task_node* next = nullptr;
+			void (*execute)(task_node*) = nullptr;
+		};
+
+		/// Singly linked FIFO of task nodes, also accepting nodes at the front.
+		struct task_list
+		{
+			task_node* head = nullptr;
+			task_node* tail = nullptr;
+
+			bool empty() const noexcept { return head == nullptr; }
+
+			void push_back(task_node* node) noexcept
+			{
+				node->next = nullptr;
+				if (tail) tail->next = node;
+				else head = node;
+				tail = node;
+			}
+
+			void push_front(task_node* node) noexcept
+			{
+				node->next = head;
+				head = node;
+				if (!tail) tail = node;
+			}
+
+			task_node* pop_front() noexcept
+			{
+				task_node* node = head;
+				head = node->next;
+				if (!head) tail = nullptr;
+				return node;
+			}
+		};
+
+		/**
+		 * \brief Result slot and task node of a `submit(priority, f)` task, shared with its `task_future`.
+		 *
+		 * Holds one reference for the pool and one for the future; whichever is
+		 * released last frees the whole task, callable included, in one delete.
+		 */
+		template<typename R>
+		struct future_state : task_node
+		{
+			using value_type = std::conditional_t<std::is_void_v<R>, bool, R>;
+
+			std::atomic<unsigned> refs{2};
+			std::atomic<bool> ready{false};
+			std::optional<value_type> value;
+			std::exception_ptr ex_ptr = nullptr;
+			void (*destroy)(future_state*) = nullptr;
+
+			/// Drop one reference, freeing the task with the last.
+			void release() noexcept
+			{
+				if (refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+					destroy(this);
+			}
+
+			/// Publish the result, wake waiters and drop the pool's reference.
+			void finish() noexcept
+			{
+				ready.store(true, std::memory_order_release);
+				ready.notify_all();
+				release();
+			}
+		};
+
+		/// `future_state` together with the callable producing its result.
+		template<typename R, typename T>
+		struct submitted_task : future_state<R>
+		{
+			T task;
+
+			explicit submitted_task(T&& t) : task(std::move(t))
+			{
+				this->execute = [](task_node* node)
+				{
+					auto* self = static_cast<submitted_task*>(node);
+					try
+					{
+						if constexpr (std::is_void_v<R>)
+						{
+							self->task();
+							self->value.emplace(true);
+						}
+						else
+							self->value.emplace(self->task());
+					}
+					catch (...)
+					{
+						self->ex_ptr = std::current_exception();
+					}
+					self->finish();
+				};
+				this->destroy = [](future_state<R>* state) { delete static_cast<submitted_task*>(state); };
+			}
+		};
+
+		/// Heap-allocated task node for `submit()`, deleted once it has run.
+		template<typename T>
+		struct boxed_task : task_node
+		{
+			T task;
+
+			explicit boxed_task(T&& t) : task(std::move(t))
+			{
+				execute = [](task_node* node)
+				{
+					auto* self = static_cast<boxed_task*>(node);
+					self->task();
+					delete self;
+				};
+			}
+		};
+	}
+
+	/**
+	 * \brief Persistent pool of worker threads.
+	 *
+	 * Workers are created once, pinned to a core, and parked on a condition
+	 * variable between jobs, so dispatching a chunk costs a wake-up instead of
+	 * a thread creation. Threads waiting on pool futures should do so through
+	 * `wait()`, which runs queued tasks while the future is not ready; that way
+	 * a task may itself dispatch onto the pool without starving it.
+	 *
+	 * Workers are pinned in `topology::scatter()` order, so consecutive workers 
+	 * land on different NUMA nodes and SMT siblings are used last. Besides the shared
+	 * queue each worker has a private queue, fed by `submit_to()`, for placing work 
+	 * on a given node.
+	 *
+	 * Tasks submitted from a worker of the pool, i.e. by nested parallel loops, go 
+	 * to the front of the shared queue, so waiting threads finish the inner loop 
+	 * before picking up further outer work. Nested loops therefore never add
+	 * threads, and the pool is traversed depth first.
+	 *
+	 * The queues are intrusive lists of `detail::task_node`s. `submit()` boxes its
+	 * task on the heap, while the parallel loops post nodes living on the caller's
+	 * stack and `join()` on a counter, so dispatching a loop does not allocate.
+	 *
+	 * The shared queue is split by `priority`. Loop chunks and plain `submit()`
+	 * tasks are `normal`; `submit(priority, f)` tasks of class `high` are taken
+	 * first, ahead of private queues too, so an interactive request waits for 
+	 * at most the chunk each worker is running. `low` tasks run only when no other
+	 * work is queued.
+	 */
+	class thread_pool
+	{
+	public:
+		/**
+		 * \brief Start `n` workers placed according to `placement`.
+		 */
+		explicit thread_pool(size_t n = runtime_threads(), const affinity& placement = affinity::from_env())
+			: _local(std::max<size_t>(n, ASYNC_MAX_THREADS)), _size(n)
+		{
+			assign(placement);
+
+			_workers.reserve(n);
+			for (size_t i = 0; i < n; ++i)
+				_workers.emplace_back([this, i] { run(i); });
+		}
+
+		~thread_pool()
+		{
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				_stop = true;
+			}
+			_cv.notify_all();
+			for (auto& worker : _workers)
+				worker.join();
+		}
+
+		thread_pool(const thread_pool&) = delete;
+		thread_pool& operator=(const thread_pool&) = delete;
+
+		/**
+		 * \brief Process-wide pool, created on first use with `runtime_threads()` workers.
+		 */
+		static thread_pool& instance()
+		{
+			static thread_pool _pool;
+			return _pool;
+		}
+
+		/// Number of worker threads.
+		size_t size() const noexcept { return _size.load(std::memory_order_relaxed); }
+
+		/// Most workers the pool can be resized to.
+		size_t capacity() const noexcept { return _local.size(); }
+
+		/**
+		 * \brief Grow or shrink the pool to `n` workers, clamped to `[1, capacity()]`.
+		 *
+		 * New workers start parked. Retiring workers finish the task they are running,
+		 * their private queues move to the shared queue, and they are joined before 
+		 * returning, so loops in flight complete on the remaining workers. Queues and
+		 * placement are sized for `capacity()` up front and never reallocated.
+		 * Must not be called from a worker of this pool.
+		 */
+		void resize(size_t n)
+		{
+			if (in_worker())
+				throw std::logic_error("thread_pool::resize called from a worker of the pool");
+			n = std::clamp<size_t>(n, 1, capacity());
+
+			std::lock_guard<std::mutex> resizing(_resize_mutex);
+			std::vector<std::thread> retired;
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				size_t current = size();
+				if (n == current) return;
+
+				_size.store(n, std::memory_order_relaxed);
+				if (n < current)
+				{
+					for (size_t i = n; i < current; ++i)
+						while (!_local[i].empty())
+							shared(priority::normal).push_back(_local[i].pop_front());
+					retired.assign(std::make_move_iterator(_workers.begin() + n), std::make_move_iterator(_workers.end()));
+					_workers.resize(n);
+				}
+				else
+				{
+					for (size_t i = current; i < n; ++i)
+						_workers.emplace_back([this, i] { run(i); });
+				}
+			}
+			_cv.notify_all();
+
+			for (auto& worker : retired)
+				worker.join();
+		}
+
+		/// CPU worker `i` is pinned to, -1 if it is not pinned.
+		int cpu_of(size_t i) const noexcept { return _cpus[i]; }
+
+		/// NUMA node of the CPU worker `i` is pinned to, 0 if it is not pinned.
+		size_t node_of(size_t i) const noexcept { return _nodes[i]; }
+
+		/// True if the calling thread is a worker of this pool.
+		bool in_worker() const noexcept { return detail::this_worker().pool == this; }
+
+		/**
+		 * \brief Index of the calling worker, or `size()` if the caller is not a worker of this pool.
+		 */
+		size_t worker_index() const noexcept { return in_worker() ? detail::this_worker().index : size(); }
+
+		/// How nested parallel loops are run.
+		nesting get_nesting() const noexcept { return _nesting.load(std::memory_order_relaxed); }
+
+		/// Set how nested parallel loops are run.
+		void set_nesting(nesting mode) noexcept { _nesting.store(mode, std::memory_order_relaxed); }
+
+		/// Current worker placement policy.
+		const affinity& get_affinity() const noexcept { return _affinity; }
+
+		/**
+		 * \brief Re-pin the running workers according to `placement`.
+		 * 
+		 * Takes effect immediately; should not race with partitioned loops that
+		 * read worker placement, such as `numa_partitioner`.
+		 */
+		void set_affinity(const affinity& placement)
+		{
+			std::lock_guard<std::mutex> resizing(_resize_mutex);
+			std::lock_guard<std::mutex> lock(_mutex);
+			assign(placement);
+			for (size_t i = 0; i < _workers.size(); ++i)
+				pin(_workers[i].native_handle(), _cpus[i]);
+		}
+
+		/**
+		 * \brief Queue a task for execution by a worker.
+		 * \tparam F Callable type
+		 * \tparam Ts Argument types
+		 * \param f Callable to execute
+		 * \param params Arguments to pass to callable
+		 * \return std::future holding the result of the task
+		 */
+		template<typename F, typename... Ts>
+		std::future<std::invoke_result_t<F, Ts...>>
+		submit(F&& f, Ts&&... params)
+		{
+			return enqueue(size(), std::forward<F>(f), std::forward<Ts>(params)...);
+		}
+
+		/**
+		 * \brief Queue a task in scheduling class `p`.
+		 *
+		 * Costs a single allocation, holding both the task and its result.
+		 * \tparam F Callable type
+		 * \tparam Ts Argument types
+		 * \param p Scheduling class
+		 * \param f Callable to execute
+		 * \param params Arguments to pass to callable
+		 * \return task_future holding the result of the task
+		 */
+		template<typename F, typename... Ts>
+		task_future<std::invoke_result_t<F, Ts...>>
+		submit(priority p, F&& f, Ts&&... params)
+		{
+			using R = std::invoke_result_t<F, Ts...>;
+			static_assert(!std::is_reference_v<R>, "submit(priority, f) requires f to return by value");
+
+			auto task = [f = std::forward<F>(f), ...params = std::forward<Ts>(params)]() mutable -> R
+			{
+				return std::invoke(f, params...);
+			};
+			auto* node = new detail::submitted_task<R, decltype(task)>(std::move(task));
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				push(node, size(), p);
+			}
+			_cv.notify_one();
+			return task_future<R>(node, *this);
+		}
+
+		/**
+		 * \brief Queue a task for execution by worker `worker`.
+		 * \see submit
+		 */
+		template<typename F, typename... Ts>
+		std::future<std::invoke_result_t<F, Ts...>>
+		submit_to(size_t worker, F&& f, Ts&&... params)
+		{
+			return enqueue(worker % size(), std::forward<F>(f), std::forward<Ts>(params)...);
+		}
+
+		/**
+		 * \brief Run one queued task on the calling thread.
+		 *
+		 * A worker of this pool takes from its private queue first.
+		 * \return false if no task was available
+		 */
+		bool try_run_one()
+		{
+			detail::task_node* task;
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				if (!(task = pop())) return false;
+			}
+			task->execute(task);
+			return true;
+		}
+
+		/**
+		 * \brief Run one queued `priority::high` task on the calling thread.
+		 *
+		 * Loop participants call this between ranges, so urgent tasks do not
+		 * wait for running loops to drain. Costs one relaxed load when none is queued.
+		 * \return false if no high-priority task was available
+		 */
+		bool run_urgent()
+		{
+			if (_urgent.load(std::memory_order_relaxed) == 0) return false;
+			detail::task_node* task;
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				if (shared(priority::high).empty()) return false;
+				task = take(priority::high);
+			}
+			task->execute(task);
+			return true;
+		}
+
+		/**
+		 * \brief Block until `fut` is ready, running queued tasks in the meantime.
+		 */
+		template<typename R>
+		void wait(std::future<R>& fut)
+		{
+			while (fut.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+				if (!try_run_one())
+				{
+					fut.wait();
+					return;
+				}
+		}
+
+		/**
+		 * \brief Queue `node` without allocating, on worker `worker`'s private queue if it is a valid index.
+		 *
+		 * `node` must stay alive until its `execute` has returned.
+		 */
+		void post(detail::task_node& node, size_t worker = static_cast<size_t>(-1))
+		{
+			bool local = worker != static_cast<size_t>(-1);
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				push(&node, local ? worker % size() : size());
+			}
+			if (local)
+				_cv.notify_all();
+			else
+				_cv.notify_one();
+		}
+
+		/**
+		 * \brief Count one task of a dispatch as done, waking `join(count)` once `count` reaches zero.
+		 *
+		 * Touches only the pool after decrementing, so the joining thread may 
+		 * destroy `count` as soon as it observes zero.
+		 */
+		void arrive(std::atomic<size_t>& count) noexcept
+		{
+			if (count.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			{
+				_completions.fetch_add(1, std::memory_order_seq_cst);
+				_completions.notify_all();
+			}
+		}
+
+		/**
+		 * \brief Block until `count` is zero, running queued tasks in the meantime.
+		 *
+		 * Once no task is queued the caller spins on `count` for `ASYNC_JOIN_SPIN`
+		 * polls, enough for a short loop to finish without a sleep and wake-up,
+		 * then parks on the pool's completion counter (a futex on Linux) until 
+		 * a dispatch completes.
+		 */
+		void join(const std::atomic<size_t>& count)
+		{
+			while (count.load(std::memory_order_acquire) != 0)
+			{
+				if (try_run_one()) continue;
+
+				for (size_t spin = 0; spin < ASYNC_JOIN_SPIN && count.load(std::memory_order_acquire) != 0; ++spin)
+					detail::cpu_relax();
+
+				unsigned seen = _completions.load(std::memory_order_seq_cst);
+				if (count.load(std::memory_order_seq_cst) == 0) break;
+				_completions.wait(seen, std::memory_order_seq_cst);
+			}
+		}
+
+	private:
+		template<typename F, typename... Ts>
+		std::future<std::invoke_result_t<F, Ts...>>
+		enqueue(size_t worker, F&& f, Ts&&... params)
+		{
+			std::packaged_task<std::invoke_result_t<F, Ts...>()> task(
+				[f = std::forward<F>(f), ...params = std::forward<Ts>(params)]() mutable
+				{
+					return std::invoke(f, params...);
+				});
+			auto fut = task.get_future();
+			auto* node = new detail::boxed_task<decltype(task)>(std::move(task));
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				push(node, worker);
+			}
+			if (worker < size())
+				_cv.notify_all();
+			else
+				_cv.notify_one();
+			return fut;
+		}
+
+		/// Shared queue of scheduling class `p`.
+		detail::task_list& shared(priority p) noexcept { return _tasks[static_cast<size_t>(p)]; }
+
+		/// True if any shared queue holds a task; `_mutex` must be held.
+		bool shared_pending() const noexcept
+		{
+			return std::ranges::any_of(_tasks, [](const detail::task_list& queue) { return !queue.empty(); });
+		}
+
+		/// Queue `node` on worker `worker`, or the shared queue of class `p` if it is `size()`; `_mutex` must be held.
+		void push(detail::task_node* node, size_t worker, priority p = priority::normal) noexcept
+		{
+			if (worker < size())
+				_local[worker].push_back(node);
+			else
+			{
+				if (p == priority::high)
+					_urgent.fetch_add(1, std::memory_order_relaxed);
+				if (in_worker())
+					shared(p).push_front(node); // nested: depth first
+				else
+					shared(p).push_back(node);
+			}
+		}
+
+		/// Take the front task of shared queue `p`, which must not be empty; `_mutex` must be held.
+		detail::task_node* take(priority p) noexcept
+		{
+			if (p == priority::high)
+				_urgent.fetch_sub(1, std::memory_order_relaxed);
+			return shared(p).pop_front();
+		}
+
+		/// Take the next task for the calling thread, or null; `_mutex` must be held.
+		detail::task_node* pop() noexcept
+		{
+			if (!shared(priority::high).empty())
+				return take(priority::high);
+			const auto& self = detail::this_worker();
+			if (self.pool == this && !_local[self.index].empty())
+				return _local[self.index].pop_front();
+			for (auto p : {priority::normal, priority::low})
+				if (!shared(p).empty())
+					return take(p);
+			return nullptr;
+		}
+
+		/// Compute the CPU and node of every worker.
+		void assign(const affinity& placement)
+		{
+			const auto& topo = topology::instance();
+			_affinity = placement;
+			_cpus = placement.placement(_local.size());
+			_nodes.resize(_cpus.size());
+			for (size_t i = 0; i < _cpus.size(); ++i)
+				_nodes[i] = (_cpus[i] < 0) ? 0 : topo.node_of(_cpus[i]);
+		}
+
+		/// Pin `thread` to `cpu`, or release it to the process cpuset if `cpu` is -1.
+		static void pin(std::thread::native_handle_type thread, int cpu)
+		{
+			#ifdef __linux__
+				cpu_set_t cpuset;
+				CPU_ZERO(&cpuset);
+				if (cpu < 0)
+					for (int allowed : topology::instance().allowed())
+						CPU_SET(allowed, &cpuset);
+				else
+					CPU_SET(cpu, &cpuset);
+				pthread_setaffinity_np(thread, sizeof(cpu_set_t), &cpuset);
+			#else
+				(void)thread;
+				(void)cpu;
+			#endif
+		}
+
+		void run(size_t id)
+		{
+			detail::this_worker() = {this, id};
+
+			#ifdef __linux__
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				if (_cpus[id] >= 0)
+					pin(pthread_self(), _cpus[id]);
+			}
+			#endif
+
+			for (;;)
+			{
+				detail::task_node* task;
+				{
+					std::unique_lock<std::mutex> lock(_mutex);
+					_cv.wait(lock, [this, id] { return _stop || id >= size() || shared_pending() || !_local[id].empty(); });
+					if (id >= size() || !(task = pop())) return; // stopped or retired by `resize()`
+				}
+				task->execute(task);
+			}
+		}
+
+		std::vector<std::thread> _workers;
+		affinity _affinity;
+		std::vector<int> _cpus;
+		std::vector<size_t> _nodes;
+		std::array<detail::task_list, priority_levels> _tasks; ///< Shared queues, indexed by `priority`
+		std::vector<detail::task_list> _local;
+		std::atomic<size_t> _size;
+		std::mutex _mutex;
+		std::mutex _resize_mutex; ///< Serialises `resize()` and `set_affinity()`
+		std::condition_variable _cv;
+		std::atomic<unsigned> _completions{0}; ///< Bumped and notified by `arrive()` when a dispatch completes
+		std::atomic<size_t> _urgent{0};        ///< Tasks in the `priority::high` queue, read without `_mutex`
+		std::atomic<nesting> _nesting{nesting::shared};
+		bool _stop = false;
+	};
+
+	namespace detail
+	{
+		/// Between the ranges of a loop participant: let a pool worker run a queued high-priority task.
+		inline void yield_to_urgent()
+		{
+			if (auto* pool = this_worker().pool)
+				pool->run_urgent();
+		}
+	}
+
+	/**
+	 * \brief Set the default thread count of parallel calls and resize the process-wide pool to match.
+	 *
+	 * `n` is clamped to `[ASYNC_MIN_THREADS, ASYNC_MAX_THREADS]`; 0 re-reads
+	 * `available_concurrency()`, e.g. after the container's CPU quota changed.
+	 * That is deliberately not cached: each `set_concurrency(0)` reads the cgroup
+	 * files again, so call it on a quota change rather than per job.
+	 * Must not be called from a pool worker.
+	 */
+	inline void set_concurrency(size_t n)
+	{
+		n = detail::clamp_threads(n == 0 ? available_concurrency() : n);
+		thread_pool::instance().resize(n);
+		detail::concurrency_value().store(n, std::memory_order_relaxed);
+	}
+
+	/**
+	 * \brief Result of a task queued with `submit(priority, f)`.
+	 *
+	 * Shares one allocation with the task instead of the separate shared state
+	 * of a `std::future`, and waits on an atomic flag. Like a `std::future` 
+	 * from `std::packaged_task`, destroying it does not wait for the task.
+	 */
+	template<typename R>
+	class task_future
+	{
+	public:
+		task_future() = default;
+
+		task_future(detail::future_state<R>* state, thread_pool& pool) noexcept
+			: _state(state), _pool(&pool)
+		{
+		}
+
+		task_future(task_future&& other) noexcept
+			: _state(std::exchange(other._state, nullptr)), _pool(other._pool)
+		{
+		}
+
+		task_future& operator=(task_future&& other) noexcept
+		{
+			if (this != &other)
+			{
+				reset();
+				_state = std::exchange(other._state, nullptr);
+				_pool = other._pool;
+			}
+			return *this;
+		}
+
+		~task_future() { reset(); }
+
+		task_future(const task_future&) = delete;
+		task_future& operator=(const task_future&) = delete;
+
+		/// True if the future refers to a task whose result has not been taken.
+		bool valid() const noexcept { return _state != nullptr; }
+
+		/// True once the task has run.
+		bool is_ready() const noexcept { return _state->ready.load(std::memory_order_acquire); }
+
+		/**
+		 * \brief Block until the task has run, running queued pool tasks in the meantime.
+		 */
+		void wait() const
+		{
+			while (!is_ready())
+				if (!_pool->try_run_one())
+					_state->ready.wait(false, std::memory_order_acquire);
+		}
+
+		/**
+		 * \brief Wait for the task and take its result, rethrowing its exception if it threw.
+		 *
+		 * Leaves the future invalid.
+		 */
+		R get()
+		{
+			wait();
+			std::unique_ptr<detail::future_state<R>, void (*)(detail::future_state<R>*)> state(
+				std::exchange(_state, nullptr), [](detail::future_state<R>* s) { s->release(); });
+			if (state->ex_ptr)
+				std::rethrow_exception(state->ex_ptr);
+			if constexpr (!std::is_void_v<R>)
+				return std::move(*state->value);
+		}
+
+	private:
+		void reset() noexcept
+		{
+			if (_state)
+				std::exchange(_state, nullptr)->release();
+		}
+
+		detail::future_state<R>* _state = nullptr;
+		thread_pool* _pool = nullptr;
+	};
+
+	/**
+	 * \brief Queue a task in scheduling class `p` on the process-wide pool.
+	 *
+	 * Unlike `call_async`, no thread is created: the task runs on a pool worker,
+	 * `priority::high` tasks ahead of the chunks of running parallel loops.
+	 * \see thread_pool::submit(priority, F&&, Ts&&...)
+	 */
+	template<typename F, typename... Ts>
+	inline task_future<std::invoke_result_t<F, Ts...>>
+	submit(priority p, F&& f, Ts&&... params)
+	{
+		return thread_pool::instance().submit(p, std::forward<F>(f), std::forward<Ts>(params)...);
+	}
+
+	/**
+	 * \brief Timing of one range of elements run by a loop participant.
+	 */
+	struct chunk_record
+	{
+		size_t thread_id = 0; ///< Participant, the thread id passed to the loop body
+		size_t first = 0;     ///< Offset of the first element
+		size_t count = 0;     ///< Number of elements
+		int cpu = -1;         ///< CPU the range started on, -1 if unknown
+		std::chrono::steady_clock::time_point start, end;
+	};
+
+	/**
+	 * \brief Timing of one participant (pool task) of a loop.
+	 */
+	struct participant_record
+	{
+		size_t thread_id = 0; ///< Thread id passed to the loop body
+		size_t worker = 0;    ///< Pool worker that ran it, the pool size for a non-worker thread
+		int cpu = -1;         ///< CPU it started on, -1 if unknown
+		size_t elements = 0;  ///< Elements in its recorded chunks
+		std::chrono::steady_clock::time_point start, end;
+	};
+
+	/**
+	 * \brief Instrumentation of one parallel call: its participants and chunks.
+	 */
+	struct call_record
+	{
+		using duration = std::chrono::steady_clock::duration;
+
+		size_t id = 0;
+		size_t worker = 0; ///< Pool worker that made the call, the pool size for a non-worker thread
+		std::chrono::steady_clock::time_point start, end;
+		std::vector<participant_record> participants;
+		std::vector<chunk_record> chunks;
+
+		/// Wall time of the call.
+		duration span() const noexcept { return end - start; }
+
+		/// Busy time summed over the participants.
+		duration work() const noexcept
+		{
+			duration total{0};
+			for (const auto& p : participants)
+				total += p.end - p.start;
+			return total;
+		}
+
+		/// Busy time of the slowest participant.
+		duration critical_path() const noexcept
+		{
+			duration longest{0};
+			for (const auto& p : participants)
+				longest = std::max(longest, p.end - p.start);
+			return longest;
+		}
+
+		/// Slowest over mean participant busy time; 1 is perfectly balanced.
+		double imbalance() const noexcept
+		{
+			if (participants.empty() || work().count() == 0) return 1.0;
+			return static_cast<double>(critical_path().count()) * static_cast<double>(participants.size()) 
+				/ static_cast<double>(work().count());
+		}
+
+		/// Mean delay from the call to a participant starting, the dispatch cost.
+		duration dispatch_latency() const noexcept
+		{
+			if (participants.empty()) return duration{0};
+			duration total{0};
+			for (const auto& p : participants)
+				total += p.start - start;
+			return total / static_cast<long>(participants.size());
+		}
+
+		/// Part of the call not covered by its slowest participant: dispatch, join and queueing.
+		duration overhead() const noexcept { return span() - critical_path(); }
+	};
+
+	/**
+	 * \brief Process-wide sink of per-call instrumentation, filled when `ASYNC_STATS` is non-zero.
+	 *
+	 * Every call dispatched through the pool's loop machinery is recorded with
+	 * the start and end of each participant and of each range it ran, the element
+	 * counts and the CPU used. Records are kept until `clear()`, can be read with
+	 * `calls()`, and dumped as Chrome trace JSON for `chrome://tracing` or Perfetto.
+	 */
+	class stats
+	{
+	public:
+		/// True if instrumentation is compiled in.
+		static constexpr bool enabled = ASYNC_STATS != 0;
+
+		static stats& instance()
+		{
+			static stats _stats;
+			return _stats;
+		}
+
+		/// Copy of the calls recorded so far, oldest first.
+		std::vector<call_record> calls() const
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			return _calls;
+		}
+
+		/// Drop the recorded calls.
+		void clear()
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_calls.clear();
+		}
+
+		/// Store a completed call, assigning it the next id.
+		void record(call_record&& call)
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			call.id = _next_id++;
+			_calls.push_back(std::move(call));
+		}
+
+		/**
+		 * \brief Write the recorded calls as Chrome trace event JSON.
+		 *
+		 * Each call, participant and chunk is a complete ("X") event on the row of
+		 * the pool worker that ran it; non-worker threads share the last row.
+		 */
+		void write_chrome_trace(std::ostream& out) const
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			auto us = [this](std::chrono::steady_clock::time_point t)
+			{
+				return std::chrono::duration<double, std::micro>(t - _epoch).count();
+			};
+			auto dur = [](auto d) { return std::chrono::duration<double, std::micro>(d).count(); };
+
+			out << "{\"traceEvents\":[";
+			bool first = true;
+			auto event = [&](const std::string& name, size_t tid, double ts, double d, const std::string& args)
+			{
+				out << (first ? "" : ",") << "\n{\"name\":\"" << name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << tid
+					<< ",\"ts\":" << ts << ",\"dur\":" << d << ",\"args\":{" << args << "}}";
+				first = false;
+			};
+
+			for (const auto& call : _calls)
+			{
+				std::ostringstream args;
+				args << "\"participants\":" << call.participants.size() << ",\"imbalance\":" << call.imbalance()
+					<< ",\"overhead_us\":" << dur(call.overhead());
+				event("call " + std::to_string(call.id), call.worker, us(call.start), dur(call.span()), args.str());
+
+				for (const auto& p : call.participants)
+				{
+					std::ostringstream pargs;
+					pargs << "\"call\":" << call.id << ",\"elements\":" << p.elements << ",\"cpu\":" << p.cpu;
+					event("participant " + std::to_string(p.thread_id), p.worker, us(p.start), dur(p.end - p.start), pargs.str());
+				}
+
+				for (const auto& c : call.chunks)
+				{
+					std::ostringstream cargs;
+					cargs << "\"call\":" << call.id << ",\"first\":" << c.first << ",\"count\":" << c.count 
+						<< ",\"cpu\":" << c.cpu;
+					size_t worker = c.thread_id < call.participants.size() ? call.participants[c.thread_id].worker : call.worker;
+					event("chunk", worker, us(c.start), dur(c.end - c.start), cargs.str());
+				}
+			}
+			out << "\n],\"displayTimeUnit\":\"ns\"}\n";
+		}
+
+		/// Write the Chrome trace JSON to `path`. \return false if the file could not be written
+		bool write_chrome_trace(const std::string& path) const
+		{
+			std::ofstream out(path);
+			write_chrome_trace(out);
+			return static_cast<bool>(out);
+		}
+
+	private:
+		stats() = default;
+
+		mutable std::mutex _mutex;
+		std::vector<call_record> _calls;
+		size_t _next_id = 0;
+		std::chrono::steady_clock::time_point _epoch = std::chrono::steady_clock::now();
+	};
+
+	namespace detail
+	{
+		/// CPU the calling thread runs on, -1 if unknown.
+		inline int current_cpu() noexcept
+		{
+			#ifdef __linux__
+				return sched_getcpu();
+			#else
+				return -1;
+			#endif
+		}
+
+		/// Call being recorded, with one participant and chunk list per task.
+		struct call_trace
+		{
+			call_record record;
+			std::vector<padded<std::vector<chunk_record>>> chunks;
+
+			explicit call_trace(size_t n) : chunks(n)
+			{
+				record.worker = thread_pool::instance().worker_index();
+				record.participants.resize(n);
+				record.start = std::chrono::steady_clock::now();
+			}
+
+			void commit()
+			{
+				record.end = std::chrono::steady_clock::now();
+				for (auto& c : chunks)
+					record.chunks.insert(record.chunks.end(), c.value.begin(), c.value.end());
+				stats::instance().record(std::move(record));
+			}
+		};
+
+		/// Participant of a traced call running on this thread, for `trace_range`.
+		struct trace_context
+		{
+			call_trace* trace = nullptr;
+			size_t id = 0;
+		};
+
+		inline trace_context& this_trace() noexcept
+		{
+			thread_local trace_context _context;
+			return _context;
+		}
+
+		/// Records participant `id` of `trace` for its lifetime, restoring any enclosing context.
+		struct participant_scope
+		{
+			trace_context saved;
+			participant_record& record;
+
+			participant_scope(call_trace& trace, size_t id) noexcept
+				: saved(this_trace()), record(trace.record.participants[id])
+			{
+				record.thread_id = id;
+				record.worker = thread_pool::instance().worker_index();
+				record.cpu = current_cpu();
+				record.start = std::chrono::steady_clock::now();
+				this_trace() = {&trace, id};
+			}
+
+			~participant_scope()
+			{
+				record.end = std::chrono::steady_clock::now();
+				this_trace() = saved;
+			}
+		};
+
+		/// Start time of a range for `trace_range`; free when instrumentation is compiled out.
+		inline std::chrono::steady_clock::time_point trace_clock() noexcept
+		{
+			if constexpr (stats::enabled)
+				return std::chrono::steady_clock::now();
+			else
+				return {};
+		}
+
+		/// Record `count` elements from offset `first`, started at `start`, for the calling participant.
+		inline void trace_range(size_t first, size_t count, std::chrono::steady_clock::time_point start)
+		{
+			if constexpr (stats::enabled)
+			{
+				trace_context& context = this_trace();
+				if (!context.trace) return;
+				context.trace->chunks[context.id].value.push_back(
+					{context.id, first, count, current_cpu(), start, std::chrono::steady_clock::now()});
+				context.trace->record.participants[context.id].elements += count;
+			}
+			else
+			{
+				(void)first;
+				(void)count;
+				(void)start;
+			}
+		}
+	}
+
+	namespace detail
+	{
+		/**
+		 * \brief Invoke the loop body with as many of (value, index, thread id) as it accepts.
+		 */
+		template<typename F, typename V>
+		inline void
+		invoke(F& f, V&& value, size_t idx, size_t thread_id)
+		{
+			if constexpr (std::is_invocable_v<F, V, size_t, size_t>)
+				f(std::forward<V>(value), idx, thread_id);
+			else if constexpr (std::is_invocable_v<F, V, size_t>)
+				f(std::forward<V>(value), idx);
+			else if constexpr (std::is_invocable_v<F, V>)
+				f(std::forward<V>(value));
+			else
+				static_assert(false, "f must be invocable with (T), (T, size_t) or (T, size_t, size_t)");
+		}
+
+		/// True if invoking the loop body `F` on `V` as `invoke` does cannot throw.
+		template<typename F, typename V>
+		inline constexpr bool nothrow_body_v = []
+		{
+			if constexpr (std::is_invocable_v<F, V, size_t, size_t>)
+				return std::is_nothrow_invocable_v<F, V, size_t, size_t>;
+			else if constexpr (std::is_invocable_v<F, V, size_t>)
+				return std::is_nothrow_invocable_v<F, V, size_t>;
+			else
+				return std::is_nothrow_invocable_v<F, V>;
+		}();
+
+		/**
+		 * \brief First-error capture and early stop shared by the tasks of one parallel call.
+		 *
+		 * The loops poll `abort` alone, which is raised by the first failure and by
+		 * `stop()`, i.e. cancellation or an early match. The first failing task
+		 * claims `failed` with a single CAS and stores its exception, so a failure 
+		 * after a stop is still reported; later failures are dropped. `ex_ptr` is 
+		 * read only by `rethrow()`, after the tasks have joined.
+		 */
+		struct error_state
+		{
+			alignas(64) std::atomic<bool> abort{false};
+			std::atomic<bool> failed{false};
+			std::exception_ptr ex_ptr = nullptr;
+
+			/// True once the call must stop: a task failed, or `stop()` was called.
+			bool aborted() const noexcept { return abort.load(std::memory_order_relaxed); }
+
+			/// Stop the call without an error.
+			void stop() noexcept { abort.store(true, std::memory_order_relaxed); }
+
+			/// Record the exception being handled, if it is the first, and abort the call.
+			void capture() noexcept
+			{
+				bool expected = false;
+				if (!failed.load(std::memory_order_relaxed) && failed.compare_exchange_strong(expected, true, std::memory_order_relaxed))
+					ex_ptr = std::current_exception();
+				stop();
+			}
+
+			/// Rethrow the captured exception, if any, in the calling thread.
+			void rethrow()
+			{
+				if (ex_ptr)
+					std::rethrow_exception(ex_ptr);
+			}
+		};
+
+		/// Placement meaning "any worker".
+		inline constexpr size_t no_worker = static_cast<size_t>(-1);
+
+		/**
+		 * \brief Pool task running `(*task)(index)` for `run_tasks`, counted down on `pending`.
+		 */
+		template<typename T>
+		struct dispatch_node : task_node
+		{
+			T* task = nullptr;
+			size_t index = 0;
+			std::atomic<size_t>* pending = nullptr;
+			error_state* errors = nullptr;
+
+			dispatch_node() noexcept
+			{
+				execute = [](task_node* node)
+				{
+					auto* self = static_cast<dispatch_node*>(node);
+					std::atomic<size_t>& pending = *self->pending;
+					try
+					{
+						(*self->task)(self->index);
+					}
+					catch (...)
+					{
+						self->errors->capture();
+					}
+					thread_pool::instance().arrive(pending);
+				};
+			}
+		};
+
+		/**
+		 * \brief Run `task(i)` for each `i` in `[0, n)` on the pool and join. 
+		 *
+		 * Exceptions escaping a task are recorded in `errors`. A single task, or any 
+		 * nested call under `nesting::serial`, runs inline on the calling thread.
+		 * Up to `ASYNC_MAX_THREADS` tasks are dispatched without heap allocation.
+		 */
+		template<typename T>
+		inline void
+		run_tasks(size_t n, T& task, error_state& errors)
+		{
+			run_tasks(n, task, errors, [](size_t) { return no_worker; });
+		}
+
+		/**
+		 * \brief Run and join the tasks of `run_tasks`.
+		 *
+		 * Tasks 1 to n-1 are queued and the caller runs task 0 itself, then joins
+		 * on the countdown, so a short call costs no wake-up of the caller.
+		 */
+		template<typename T, typename W>
+		inline void
+		dispatch_tasks(size_t n, T& task, error_state& errors, W& place)
+		{
+			thread_pool& pool = thread_pool::instance();
+
+			if (n == 1 || (pool.in_worker() && pool.get_nesting() == nesting::serial))
+			{
+				for (size_t i = 0; i < n; ++i)
+				{
+					try
+					{
+						task(i);
+					}
+					catch (...)
+					{
+						errors.capture();
+					}
+				}
+				return;
+			}
+
+			// Descriptors live on this stack frame; only oversubscribed calls allocate.
+			std::array<dispatch_node<T>, ASYNC_MAX_THREADS> inline_nodes;
+			std::unique_ptr<dispatch_node<T>[]> heap_nodes;
+			dispatch_node<T>* nodes = inline_nodes.data();
+			if (n > inline_nodes.size())
+			{
+				heap_nodes = std::make_unique<dispatch_node<T>[]>(n);
+				nodes = heap_nodes.get();
+			}
+
+			// The caller runs task 0 itself unless it is placed on a given worker.
+			const bool caller_runs_first = place(0) == no_worker;
+			alignas(64) std::atomic<size_t> pending{caller_runs_first ? n - 1 : n};
+
+			for (size_t i = caller_runs_first ? 1 : 0; i < n; ++i)
+			{
+				nodes[i].task = &task;
+				nodes[i].index = i;
+				nodes[i].pending = &pending;
+				nodes[i].errors = &errors;
+				pool.post(nodes[i], place(i));
+			}
+
+			if (caller_runs_first)
+			{
+				try
+				{
+					task(0);
+				}
+				catch (...)
+				{
+					errors.capture();
+				}
+			}
+
+			pool.join(pending);
+		}
+
+		/**
+		 * \brief As `run_tasks`, queueing task `i` on pool worker `place(i)` unless that is `no_worker`.
+		 */
+		template<typename T, typename W>
+		inline void
+		run_tasks(size_t n, T& task, error_state& errors, W&& place)
+		{
+			if constexpr (stats::enabled)
+			{
+				call_trace trace(n);
+				auto traced = [&](size_t i)
+				{
+					participant_scope scope(trace, i);
+					task(i);
+				};
+				dispatch_tasks(n, traced, errors, place);
+				trace.commit();
+			}
+			else
+				dispatch_tasks(n, task, errors, place);
+		}
+
+		/// Nodes claimed per cursor step when no grain is given for an iterator that is not random access.
+		inline constexpr size_t node_batch = 256;
+
+		/**
+		 * \brief Shared cursor handing out batches of nodes of a forward range.
+		 *
+		 * The range is walked once, by whichever participant claims the next batch,
+		 * so no length or chunk bounds are computed up front and chunks start being
+		 * processed as soon as they are found. `end` may be a sentinel of another
+		 * type, so views such as `take` need no common end iterator.
+		 */
+		template<typename I, typename S = I>
+		struct node_cursor
+		{
+			std::mutex mutex;
+			I it;
+			S end;
+			size_t index = 0;
+
+			node_cursor(I first, S last) : it(first), end(last) {}
+
+			/// Claim up to `grain` nodes as `[first, last)` starting at offset `first_index`. \return the nodes claimed, 0 once the range is exhausted
+			size_t next(size_t grain, I& first, I& last, size_t& first_index)
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				if (it == end) return 0;
+				first = it;
+				first_index = index;
+				for (size_t n = 0; n < grain && it != end; ++n, ++index) ++it;
+				last = it;
+				return index - first_index;
+			}
+		};
+
+		/**
+		 * \brief Run `body(first, last, first_index, thread_id)` over batches of `[begin, end)` pulled from a `node_cursor`.
+		 *
+		 * The caller claims the first batch, of at least `min_grain()` nodes, before
+		 * dispatching: if that exhausts the range the loop runs inline as a single
+		 * participant, the serial cutoff of random-access loops without a length.
+		 * `finish(thread_id)` is called once per participant that finished without error.
+		 */
+		template<typename I, typename S, typename B, typename D>
+		inline void
+		run_cursor(I begin, S end, size_t grain, size_t threads, error_state& errors, B&& body, D&& finish)
+		{
+			node_cursor<I, S> cursor(begin, end);
+			grain = std::max<size_t>(1, grain);
+
+			// A noexcept body cannot abort the call: skip the polls and the try.
+			constexpr bool nothrow = std::is_nothrow_invocable_v<B&, I, I, size_t, size_t>;
+
+			auto batch = [&](I first, I last, size_t first_index, size_t count, size_t id)
+			{
+				auto start = trace_clock();
+				body(first, last, first_index, id);
+				trace_range(first_index, count, start);
+				yield_to_urgent();
+			};
+
+			// Participant 0 starts with the probe batch.
+			I probe_first, probe_last;
+			size_t probe_index = 0;
+			size_t probe_count = cursor.next(std::max(grain, min_grain()), probe_first, probe_last, probe_index);
+			if (cursor.it == cursor.end)
+				threads = 1;
+
+			auto drain = [&](size_t id)
+			{
+				if (id == 0 && probe_count != 0)
+					batch(probe_first, probe_last, probe_index, probe_count, id);
+
+				I first, last;
+				size_t first_index, count;
+				while ((nothrow || !errors.aborted()) && (count = cursor.next(grain, first, last, first_index)) != 0)
+					batch(first, last, first_index, count, id);
+				if (nothrow || !errors.aborted())
+					finish(id);
+			};
+
+			// Anything else that throws, such as `finish`, is captured by the dispatch.
+			auto task = [&](size_t id)
+			{
+				if constexpr (nothrow)
+					drain(id);
+				else
+				{
+					try
+					{
+						drain(id);
+					}
+					catch (...)
+					{
+						errors.capture();
+					}
+				}
+			};
+
+			run_tasks(std::max<size_t>(1, threads), task, errors);
+		}
+
+		/**
+		 * \brief For-each over a forward range through `run_cursor`; the index is the element's offset from `begin`.
+		 */
+		template<typename I, typename S, typename F, typename P>
+		inline void
+		cursor_for_each(I begin, S end, size_t grain, F& f, size_t threads, error_state& errors, P& progress)
+		{
+			alignas(64) std::atomic<size_t> completed{0};
+			constexpr bool nothrow = nothrow_body_v<F&, std::iter_reference_t<I>>;
+
+			auto body = [&](I first, I last, size_t idx, size_t id) noexcept(nothrow)
+			{
+				for (auto it = first; it != last; ++it)
+				{
+					if constexpr (!nothrow)
+						if (errors.aborted()) break;
+					invoke(f, *it, idx++, id);
+				}
+			};
+
+			auto finish = [&](size_t)
+			{
+				auto prev_completed = completed.fetch_add(1, std::memory_order_relaxed);
+				progress(prev_completed + 1);
+			};
+
+			run_cursor(begin, end, grain, threads, errors, body, finish);
+		}
+	}
+
+	/**
+	 * \brief Element-granular progress callback for `async_for_each`, in place of the per-thread one.
+	 *
+	 * Each participant counts its elements locally and adds them to a shared
+	 * counter every `every` elements. Only participant 0 reports: when it publishes
+	 * and at least `interval` has passed since the last report, it runs
+	 * `callback(processed)` with the shared count. Participant 0 runs on the
+	 * calling thread, unless a placing partitioner such as `numa_partitioner` 
+	 * puts it on a worker, and the final report with the full count follows the
+	 * join on the calling thread. Reports thus come from one thread at a time,
+	 * normally always the caller, and the counts they see never decrease, so the
+	 * callback needs neither synchronisation nor thread-safe state.
+	 * Once participant 0 runs out of work, reports pause until the final one.
+	 *
+	 * \tparam F Callable type, invoked as `callback(size_t processed)`
+	 */
+	template<typename F>
+	struct throttled_progress
+	{
+		F callback;
+		size_t every = 4096;                           ///< Elements counted per thread before publishing
+		std::chrono::microseconds interval{100000};    ///< Minimum time between reports
+	};
+
+	template<typename F>
+	throttled_progress(F, size_t = 0, std::chrono::microseconds = {}) -> throttled_progress<F>;
+
+	template<typename T>
+	struct is_throttled_progress : std::false_type {};
+
+	template<typename F>
+	struct is_throttled_progress<throttled_progress<F>> : std::true_type {};
+
+	template<typename T>
+	inline constexpr bool is_throttled_progress_v = is_throttled_progress<std::remove_cvref_t<T>>::value;
+
+	namespace detail
+	{
+		/**
+		 * \brief Per-thread element counts behind a `throttled_progress`.
+		 */
+		template<typename F>
+		class progress_meter
+		{
+		public:
+			progress_meter(throttled_progress<F>& progress, size_t threads)
+				: _progress(progress), 
+				  _every(std::max<size_t>(1, progress.every)),
+				  _interval(std::chrono::duration_cast<std::chrono::steady_clock::duration>(progress.interval)),
+				  _local(std::max<size_t>(1, threads)),
+				  _last(std::chrono::steady_clock::now())
+			{}
+
+			/// Count one element processed by participant `id`.
+			void tick(size_t id)
+			{
+				size_t& pending = _local[id].value;
+				if (++pending < _every) return;
+				_done.value.fetch_add(pending, std::memory_order_relaxed);
+				pending = 0;
+				if (id == 0)
+					report();
+			}
+
+			/// Report the full count; call on the calling thread once the participants have joined.
+			void finish()
+			{
+				size_t done = _done.value.load(std::memory_order_relaxed);
+				for (const auto& pending : _local)
+					done += pending.value;
+				_progress.callback(done);
+			}
+
+		private:
+			/// Run the callback if the interval has passed; participant 0 only.
+			void report()
+			{
+				auto now = std::chrono::steady_clock::now();
+				if (now - _last < _interval) return;
+				_last = now;
+				_progress.callback(_done.value.load(std::memory_order_relaxed));
+			}
+
+			throttled_progress<F>& _progress;
+			size_t _every;
+			std::chrono::steady_clock::duration _interval;
+			std::vector<padded<size_t>> _local;
+			padded<std::atomic<size_t>> _done{0};
+			std::chrono::steady_clock::time_point _last; ///< Touched by participant 0, then by `finish()` after the join
+		};
+
+		/**
+		 * \brief Run `loop(counted)` with `counted` invoking `f` and counting each element on `meter`.
+		 */
+		template<typename F, typename M, typename L>
+		inline void
+		with_progress(F& f, M& meter, L&& loop)
+		{
+			auto counted = [&](auto&& value, size_t idx, size_t id) -> void
+			{
+				invoke(f, std::forward<decltype(value)>(value), idx, id);
+				meter.tick(id);
+			};
+			loop(counted);
+			meter.finish();
+		}
+	}
+
+	/**
+	 * \brief Launches a parallel for-each operation across a range using asynchronous tasks.
+	 * 
+	 * Optimized with atomic operations for better performance.
+	 * Iterators that are not random access are walked once, with participants
+	 * pulling batches of nodes from a shared cursor, instead of paying for the
+	 * length and the chunk bounds serially before any work starts.
+	 * 
+	 * \tparam I Iterator type
+	 * \tparam F Callable type
+	 * \tparam P Progress callback type
+	 * \param begin Iterator to start of range
+	 * \param end Iterator to end of range
+	 * \param f Function to invoke on each element (can optionally take an index)
+	 * \param threads Number of threads to use
+	 * \param progress Optional progress callback (receives count of completed threads), or a `throttled_progress`
+	 */
+	template<typename I, typename F, typename P>
+	inline void 
+	async_for_each(I begin, I end, F&& f,
+						size_t threads = runtime_threads(),
+						P&& progress = [](size_t) {})
+	{
+		detail::error_state errors;
+
+		if constexpr (!is_random_access_iterator_v<I>)
+		{
+			// Node batches from a shared cursor: a single walk, no up-front length.
+			if (begin == end) return;
+			detail::cursor_for_each(begin, end, detail::node_batch, f, threads, errors, progress);
+			errors.rethrow();
+			return;
+		}
+
+		auto size = std::ranges::distance(begin, end);
+		if (size == 0) return;
+
+		threads = detail::cap_threads(threads, static_cast<size_t>(size));
+		auto chunk_size = size / threads;
+
+		alignas(64) std::atomic<size_t> completed{0};
+
+		// A noexcept body needs neither the abort poll nor the try; a throwing
+		// progress callback is still captured by the dispatch.
+		constexpr bool nothrow = detail::nothrow_body_v<F&, std::iter_reference_t<I>>;
+
+		auto chunk = [&](size_t i)
+		{
+			I local_chunk_begin = std::ranges::next(begin, i * chunk_size);
+			I local_chunk_end = (i == threads - 1) ? end : std::ranges::next(local_chunk_begin, chunk_size);
+
+			// The last chunk also takes the remainder, so offsets follow the common chunk size.
+			size_t idx_offset = i * chunk_size;
+
+			auto start = detail::trace_clock();
+			size_t idx = idx_offset;
+			for (auto it = local_chunk_begin; it != local_chunk_end; ++it)
+			{
+				if constexpr (!nothrow)
+					if (errors.aborted()) break;
+				detail::invoke(f, *it, idx++, i); // i is the thread id
+			}
+			detail::trace_range(idx_offset, idx - idx_offset, start);
+
+			auto prev_completed = completed.fetch_add(1, std::memory_order_relaxed);
+			progress(prev_completed + 1);
+		};
+
+		auto task = [&](size_t i)
+		{
+			if constexpr (nothrow)
+				chunk(i);
+			else
+			{
+				try
+				{
+					chunk(i);
+				}
+				catch (...)
+				{
+					errors.capture();
+				}
+			}
+		};
+
+		detail::run_tasks(threads, task, errors);
+		errors.rethrow();
+	}
+
+	/**
+	 * \brief Overload of async_for_each reporting element-granular progress through a `throttled_progress`.
+	 */
+	template<typename I, typename F, typename P>
+		requires is_throttled_progress_v<P>
+	inline void 
+	async_for_each(I begin, I end, F&& f, size_t threads, P&& progress)
+	{
+		detail::progress_meter meter(progress, threads);
+		detail::with_progress(f, meter, [&](auto& counted) { async_for_each(begin, end, counted, threads, [](size_t) {}); });
+	}
+
+	/**
+	 * \brief Overload of async_for_each without progress callback.
+	 */
+	template<typename I, typename F>
+	inline void async_for_each(I begin, I end, F&& f, size_t threads = runtime_threads()) 
+	{
+		async_for_each(begin, end, std::forward<F>(f), threads, [](size_t) {});
+	}
+
+	/**
+	 * \brief Static execution policy: `threads` equal contiguous chunks (the default).
+	 *
+	 * By default the last chunk also takes the `size % threads` remainder; 
+	 * `balanced` spreads it one element each over the first chunks instead,
+	 * so no chunk is more than one element longer than another.
+	 */
+	struct static_partitioner
+	{
+		bool balanced = false; ///< Spread the remainder over the first chunks.
+	};
+
+	/**
+	 * \brief Dynamic execution policy, like OpenMP `schedule(dynamic, grain)`.
+	 *
+	 * Threads repeatedly claim the next `grain` elements from a shared atomic cursor.
+	 */
+	struct dynamic_partitioner
+	{
+		size_t grain = 1; ///< Elements claimed per cursor increment.
+	};
+
+	/**
+	 * \brief Guided execution policy, like OpenMP `schedule(guided, grain)`.
+	 *
+	 * Threads claim `remaining / threads` elements from a shared atomic cursor,
+	 * so blocks shrink geometrically towards the end, but never below `grain`.
+	 */
+	struct guided_partitioner
+	{
+		size_t grain = 1; ///< Smallest block claimed.
+	};
+
+	/**
+	 * \brief Work-stealing execution policy.
+	 *
+	 * Each participating thread owns a deque of index ranges. It recursively
+	 * halves its current range, pushing the upper half onto its deque, until
+	 * the range is no larger than `grain`; a thread whose deque runs dry steals
+	 * the oldest, largest range from another thread, in the manner of
+	 * `tbb::blocked_range`. A `grain` of 0 picks `size / (8 * threads)`.
+	 */
+	struct stealing_partitioner
+	{
+		size_t grain = 0; ///< Largest range that is not split further.
+	};
+
+	/**
+	 * \brief NUMA-aware static execution policy.
+	 *
+	 * `threads` equal contiguous chunks, chunk `i` run by a pool worker on node
+	 * `i * nodes / threads`, so consecutive slices of the range map onto 
+	 * consecutive nodes. Memory initialised with `async_first_touch` under the
+	 * same thread count is then accessed node-locally.
+	 */
+	struct numa_partitioner {};
+
+	/**
+	 * \brief Self-tuning execution policy.
+	 *
+	 * The first `samples` calls from a call site (the loop body's type) time 
+	 * their first `probe` elements inline. From the measured per-element cost 
+	 * each call then decides whether to run inline, how many threads to use and
+	 * the block size handed out by a dynamic schedule, weighed against
+	 * `ASYNC_TASK_OVERHEAD_NS` per task. Outside `async_for_each` it behaves as
+	 * `guided_partitioner` with a grain of `min_grain()`.
+	 */
+	struct adaptive_partitioner
+	{
+		size_t samples = 4; ///< Calls per call site that measure the per-element cost
+		size_t probe = 64;  ///< Elements timed inline by a measuring call
+	};
+
+	/// Trait for execution policies accepted by the partitioned `async_for_each`
+	template<typename T>
+	constexpr bool is_partitioner_v = 
+		std::same_as<T, static_partitioner> || std::same_as<T, dynamic_partitioner> ||
+		std::same_as<T, guided_partitioner> || std::same_as<T, stealing_partitioner> ||
+		std::same_as<T, numa_partitioner> || std::same_as<T, adaptive_partitioner>;
+
+	template<typename T>
+	concept partitioner = is_partitioner_v<std::remove_cvref_t<T>>;
+
+	namespace detail
+	{
+		/// Half-open index range `[first, last)`.
+		struct index_range
+		{
+			size_t first;
+			size_t last;
+
+			size_t size() const noexcept { return last - first; }
+		};
+
+		/*
+		 * Schedules hand index ranges of `[0, size)` to the participants of one
+		 * partitioned call: participant `id` calls `next(id, r)`, with `r` holding
+		 * its previous range (empty on the first call), until it returns false,
+		 * and `done(r)` after processing each range.
+		 */
+
+		/// One chunk per participant, remainder on the last.
+		/**
+		 * \brief Chunk `i` of `[0, size)` split `threads` ways, the remainder on the last chunk or, if `balanced`, on the first.
+		 */
+		inline index_range
+		static_chunk(size_t i, size_t size, size_t threads, bool balanced) noexcept
+		{
+			size_t chunk_size = size / threads;
+			if (!balanced)
+				return {i * chunk_size, (i == threads - 1) ? size : (i + 1) * chunk_size};
+
+			size_t extra = size % threads;
+			size_t first = i * chunk_size + std::min(i, extra);
+			return {first, first + chunk_size + (i < extra ? 1 : 0)};
+		}
+
+		struct static_schedule
+		{
+			size_t size;
+			size_t threads;
+			bool balanced = false;
+
+			bool next(size_t id, index_range& r) const noexcept
+			{
+				if (r.last != 0 || id >= threads) return false; // one chunk per participant
+				r = static_chunk(id, size, threads, balanced);
+				return true;
+			}
+
+			void done(const index_range&) noexcept {}
+		};
+
+		/// Static chunks placed on the workers of the node owning their slice.
+		struct numa_schedule : static_schedule
+		{
+			std::vector<size_t> workers;
+
+			numa_schedule(size_t size, size_t threads)
+				: static_schedule{size, threads}, workers(threads, no_worker)
+			{
+				thread_pool& pool = thread_pool::instance();
+				const size_t nodes = topology::instance().nodes();
+				if (nodes < 2) return;
+
+				std::vector<std::vector<size_t>> node_workers(nodes);
+				for (size_t w = 0; w < pool.size(); ++w)
+					node_workers[pool.node_of(w)].push_back(w);
+
+				for (size_t i = 0; i < threads; ++i)
+				{
+					size_t node = i * nodes / threads;
+					size_t rank = i - (node * threads + nodes - 1) / nodes; // position of chunk i within its node
+					if (!node_workers[node].empty())
+						workers[i] = node_workers[node][rank % node_workers[node].size()];
+				}
+			}
+
+			size_t place(size_t id) const noexcept { return workers[id]; }
+		};
+
+		/// Fixed-size blocks from a shared cursor.
+		struct dynamic_schedule
+		{
+			size_t size;
+			size_t grain;
+			alignas(64) std::atomic<size_t> cursor{0};
+
+			bool next(size_t, index_range& r) noexcept
+			{
+				size_t first = cursor.fetch_add(grain, std::memory_order_relaxed);
+				if (first >= size) return false;
+				r = {first, std::min(first + grain, size)};
+				return true;
+			}
+
+			void done(const index_range&) noexcept {}
+		};
+
+		/// Geometrically shrinking blocks from a shared cursor.
+		struct guided_schedule
+		{
+			size_t size;
+			size_t grain;
+			size_t threads;
+			alignas(64) std::atomic<size_t> cursor{0};
+
+			bool next(size_t, index_range& r) noexcept
+			{
+				size_t first = cursor.load(std::memory_order_relaxed);
+				size_t last;
+				do
+				{
+					if (first >= size) return false;
+					size_t block = std::max(grain, (size - first + threads - 1) / threads);
+					last = std::min(first + block, size);
+				}
+				while (!cursor.compare_exchange_weak(first, last, std::memory_order_relaxed));
+				r = {first, last};
+				return true;
+			}
+
+			void done(const index_range&) noexcept {}
+		};
+
+		/**
+		 * \brief Bounded deque of index ranges owned by one participant of a stealing schedule.
+		 *
+		 * Repeated halving keeps at most log2(size) ranges per owner, so a fixed ring
+		 * suffices; a full deque simply stops the owner from splitting.
+		 */
+		struct alignas(64) range_deque
+		{
+			static constexpr size_t capacity = 64;
+
+			std::mutex mutex;
+			std::array<index_range, capacity> ranges;
+			size_t head = 0; ///< Oldest range, taken by thieves.
+			size_t tail = 0; ///< One past the newest range, taken by the owner.
+
+			bool push_back(index_range r)
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				if (tail - head == capacity) return false;
+				ranges[tail++ % capacity] = r;
+				return true;
+			}
+
+			bool pop_back(index_range& r)
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				if (tail == head) return false;
+				r = ranges[--tail % capacity];
+				return true;
+			}
+
+			bool pop_front(index_range& r)
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				if (tail == head) return false;
+				r = ranges[head++ % capacity];
+				return true;
+			}
+		};
+
+		/// Per-participant deques with recursive splitting and stealing.
+		struct stealing_schedule
+		{
+			size_t grain;
+			std::vector<range_deque> deques;
+			alignas(64) std::atomic<size_t> remaining;
+			const error_state& errors;
+
+			stealing_schedule(size_t size, size_t threads, size_t grain, const error_state& errors)
+				: grain(grain ? grain : std::max<size_t>(1, size / (8 * threads))), 
+				deques(threads), remaining(size), errors(errors)
+			{
+				for (size_t i = 0; i < threads; ++i)
+					deques[i].push_back({i * size / threads, (i + 1) * size / threads});
+			}
+
+			bool next(size_t id, index_range& r)
+			{
+				const size_t n = deques.size();
+
+				if (!deques[id].pop_back(r))
+				{
+					bool stolen = false;
+					while (!stolen && remaining.load(std::memory_order_acquire) > 0 && !errors.aborted())
+					{
+						for (size_t k = 1; k < n && !stolen; ++k)
+							stolen = deques[(id + k) % n].pop_front(r);
+						if (!stolen) std::this_thread::yield();
+					}
+					if (!stolen) return false;
+				}
+
+				while (r.size() > grain)
+				{
+					size_t mid = r.first + r.size() / 2;
+					if (!deques[id].push_back({mid, r.last})) break;
+					r.last = mid;
+				}
+				return true;
+			}
+
+			void done(const index_range& r) noexcept
+			{
+				remaining.fetch_sub(r.size(), std::memory_order_acq_rel);
+			}
+		};
+
+		inline static_schedule 
+		make_schedule(static_partitioner part, size_t size, size_t threads, const error_state&)
+		{
+			return {size, threads, part.balanced};
+		}
+
+		inline numa_schedule 
+		make_schedule(numa_partitioner, size_t size, size_t threads, const error_state&)
+		{
+			return {size, threads};
+		}
+
+		inline dynamic_schedule 
+		make_schedule(dynamic_partitioner part, size_t size, size_t, const error_state&)
+		{
+			return {size, std::max<size_t>(1, part.grain)};
+		}
+
+		inline guided_schedule 
+		make_schedule(guided_partitioner part, size_t size, size_t threads, const error_state&)
+		{
+			return {size, std::max<size_t>(1, part.grain), threads};
+		}
+
+		inline stealing_schedule 
+		make_schedule(stealing_partitioner part, size_t size, size_t threads, const error_state& errors)
+		{
+			return {size, threads, part.grain, errors};
+		}
+
+		inline guided_schedule 
+		make_schedule(adaptive_partitioner, size_t size, size_t threads, const error_state&)
+		{
+			return {size, min_grain(), threads};
+		}
+
+		/// Nodes per cursor step over a range that is not random access; only the dynamic grain carries over.
+		template<partitioner Pt>
+		inline size_t 
+		node_grain(Pt part)
+		{
+			if constexpr (std::same_as<Pt, dynamic_partitioner>)
+				return part.grain;
+			else
+				return node_batch;
+		}
+
+		/**
+		 * \brief Invoke `f` on elements `[first, last)` of the range starting at `begin`, stopping on abort.
+		 */
+		template<typename I, typename F>
+		inline void
+		for_each_range(I begin, size_t first, size_t last, F& f, size_t thread_id, const error_state& errors)
+		{
+			auto it = std::ranges::next(begin, first);
+			for (size_t idx = first; idx < last; ++idx, ++it)
+			{
+				if constexpr (!nothrow_body_v<F&, decltype(*it)>)
+					if (errors.aborted()) break;
+				invoke(f, *it, idx, thread_id);
+			}
+		}
+
+		/**
+		 * \brief Run `threads` participants of `sched` on the pool, calling `body(first, last, id)` per range.
+		 *
+		 * `finish(id)` runs once a participant has drained the schedule without error.
+		 */
+		template<typename S, typename B, typename D>
+		inline void
+		run_schedule(S& sched, size_t threads, error_state& errors, B& body, D& finish)
+		{
+			// A noexcept body cannot abort the call: skip the poll and the try.
+			constexpr bool nothrow = std::is_nothrow_invocable_v<B&, size_t, size_t, size_t>;
+
+			auto drain = [&](size_t id)
+			{
+				index_range r{0, 0};
+				while ((nothrow || !errors.aborted()) && sched.next(id, r))
+				{
+					auto start = trace_clock();
+					body(r.first, r.last, id);
+					trace_range(r.first, r.last - r.first, start);
+					sched.done(r);
+					yield_to_urgent();
+				}
+				finish(id);
+			};
+
+			// Anything else that throws, such as `finish`, is captured by the dispatch.
+			auto task = [&](size_t id)
+			{
+				if constexpr (nothrow)
+					drain(id);
+				else
+				{
+					try
+					{
+						drain(id);
+					}
+					catch (...)
+					{
+						errors.capture();
+					}
+				}
+			};
+
+			if constexpr (requires { sched.place(size_t{}); })
+				run_tasks(threads, task, errors, [&](size_t id) { return sched.place(id); });
+			else
+				run_tasks(threads, task, errors);
+		}
+
+		/**
+		 * \brief Run `body(first, last, id)` over `[0, size)` split by `part` and join.
+		 */
+		template<typename Pt, typename B>
+		inline void
+		run_partitioned(Pt part, size_t size, size_t threads, error_state& errors, B& body)
+		{
+			auto sched = make_schedule(part, size, threads, errors);
+			auto finish = [](size_t) {};
+			run_schedule(sched, threads, errors, body, finish);
+		}
+
+		/**
+		 * \brief Per-element cost measured at one call site of the adaptive partitioner.
+		 *
+		 * The sample count and the mean share one atomic word, a count in the high
+		 * half and the mean as a `float` in the low half, so concurrent `record()`s
+		 * never lose a sample and `cost_ns()` is always the mean of `samples()`
+		 * measurements.
+		 */
+		struct tuning_site
+		{
+			/// Number of measurements taken.
+			size_t samples() const noexcept { return static_cast<size_t>(_state.load(std::memory_order_relaxed) >> 32); }
+
+			/// Mean over the samples, in nanoseconds per element.
+			double cost_ns() const noexcept { return mean_of(_state.load(std::memory_order_relaxed)); }
+
+			void record(double ns) noexcept
+			{
+				uint64_t current = _state.load(std::memory_order_relaxed), next;
+				do
+				{
+					uint64_t n = current >> 32;
+					double mean = (mean_of(current) * static_cast<double>(n) + ns) / static_cast<double>(n + 1);
+					next = ((n + 1) << 32) | std::bit_cast<uint32_t>(static_cast<float>(mean));
+				}
+				while (!_state.compare_exchange_weak(current, next, std::memory_order_relaxed));
+			}
+
+		private:
+			static double mean_of(uint64_t state) noexcept { return std::bit_cast<float>(static_cast<uint32_t>(state)); }
+
+			std::atomic<uint64_t> _state{0};
+		};
+
+		/// Tuning state of the call sites whose loop body has type `F`.
+		template<typename F>
+		inline tuning_site& site_of() noexcept
+		{
+			static tuning_site _site;
+			return _site;
+		}
+
+		/// Threads and block size chosen for `size` elements costing `cost_ns` each.
+		struct tuning_plan
+		{
+			size_t threads;
+			size_t grain;
+		};
+
+		inline tuning_plan
+		plan(double cost_ns, size_t size, size_t threads) noexcept
+		{
+			const double overhead = ASYNC_TASK_OVERHEAD_NS;
+			const double work = cost_ns * static_cast<double>(size);
+
+			// Each extra thread must be worth a few dispatch overheads of work.
+			size_t t = cap_threads(threads, size);
+			t = std::min(t, static_cast<size_t>(work / (4 * overhead)));
+			if (t <= 1) return {1, size};
+
+			// Blocks of about one overhead of work, with at least four per thread for balance.
+			size_t grain = cost_ns > 0 ? static_cast<size_t>(overhead / cost_ns) : size;
+			grain = std::min(grain, size / (4 * t));
+			return {t, std::max(grain, min_grain())};
+		}
+	}
+
+	/**
+	 * \brief Parallel for-each with a selectable partitioning policy.
+	 *
+	 * `static_partitioner` is the default split, `dynamic_partitioner` and
+	 * `guided_partitioner` hand out blocks from a shared cursor, and
+	 * `stealing_partitioner` balances irregular workloads by work stealing.
+	 * `adaptive_partitioner` picks inline execution, the thread count and the 
+	 * block size from the per-element cost it measures at the call site.
+	 * Except for the static split, the index passed to `f` is the element's
+	 * offset from `begin` and the thread id that of the participant running it.
+	 * Iterators that are not random access pull node batches from a shared
+	 * cursor, `grain` nodes at a time for `dynamic_partitioner`.
+	 *
+	 * \tparam Pt Partitioner type
+	 * \param part Partitioning policy
+	 * \param begin Iterator to start of range
+	 * \param end Iterator to end of range
+	 * \param f Function to invoke on each element (can optionally take an index)
+	 * \param threads Number of threads to use
+	 * \param progress Progress callback (receives count of completed threads), or a `throttled_progress`
+	 */
+	template<partitioner Pt, typename I, typename F, typename P>
+	inline void 
+	async_for_each(Pt part, I begin, I end, F&& f, size_t threads, P&& progress)
+	{
+		if constexpr (std::same_as<Pt, static_partitioner>)
+		{
+			// A balanced split goes through the schedule below.
+			if (!part.balanced || !is_random_access_iterator_v<I>)
+			{
+				async_for_each(begin, end, std::forward<F>(f), threads, std::forward<P>(progress));
+				return;
+			}
+		}
+
+		if constexpr (!is_random_access_iterator_v<I>)
+		{
+			if (begin == end) return;
+			detail::error_state errors;
+			detail::cursor_for_each(begin, end, detail::node_grain(part), f, threads, errors, progress);
+			errors.rethrow();
+		}
+		else if constexpr (std::same_as<Pt, adaptive_partitioner>)
+		{
+			size_t size = static_cast<size_t>(std::ranges::distance(begin, end));
+			if (size == 0) return;
+
+			detail::tuning_site& site = detail::site_of<std::remove_cvref_t<F>>();
+			detail::error_state errors;
+			size_t start = 0;
+
+			if (site.samples() < part.samples)
+			{
+				// The timed elements are part of the loop, run inline as thread 0.
+				start = std::min(size, std::max<size_t>(1, part.probe));
+				auto t0 = std::chrono::steady_clock::now();
+				detail::for_each_range(begin, 0, start, f, 0, errors);
+				std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - t0;
+				site.record(elapsed.count() / static_cast<double>(start));
+			}
+
+			auto [t, grain] = detail::plan(site.cost_ns(), size - start, threads);
+			if (t <= 1)
+			{
+				detail::for_each_range(begin, start, size, f, 0, errors);
+				progress(1);
+				return;
+			}
+
+			alignas(64) std::atomic<size_t> completed{0};
+			detail::dynamic_schedule sched{size - start, grain};
+
+			auto body = [&](size_t first, size_t last, size_t id) noexcept(detail::nothrow_body_v<F&, std::iter_reference_t<I>>)
+			{
+				detail::for_each_range(begin, start + first, start + last, f, id, errors);
+			};
+
+			auto finish = [&](size_t)
+			{
+				auto prev_completed = completed.fetch_add(1, std::memory_order_relaxed);
+				progress(prev_completed + 1);
+			};
+
+			detail::run_schedule(sched, t, errors, body, finish);
+			errors.rethrow();
+		}
+		else
+		{
+			size_t size = static_cast<size_t>(std::ranges::distance(begin, end));
+			if (size == 0) return;
+
+			threads = detail::cap_threads(threads, size);
+			alignas(64) std::atomic<size_t> completed{0};
+			detail::error_state errors;
+			auto sched = detail::make_schedule(part, size, threads, errors);
+
+			auto body = [&](size_t first, size_t last, size_t id) noexcept(detail::nothrow_body_v<F&, std::iter_reference_t<I>>)
+			{
+				detail::for_each_range(begin, first, last, f, id, errors);
+			};
+
+			auto finish = [&](size_t)
+			{
+				auto prev_completed = completed.fetch_add(1, std::memory_order_relaxed);
+				progress(prev_completed + 1);
+			};
+
+			detail::run_schedule(sched, threads, errors, body, finish);
+			errors.rethrow();
+		}
+	}
+
+	/**
+	 * \brief Overload of the partitioned async_for_each reporting element-granular progress through a `throttled_progress`.
+	 */
+	template<partitioner Pt, typename I, typename F, typename P>
+		requires is_throttled_progress_v<P>
+	inline void 
+	async_for_each(Pt part, I begin, I end, F&& f, size_t threads, P&& progress)
+	{
+		detail::progress_meter meter(progress, threads);
+		detail::with_progress(f, meter, [&](auto& counted) { async_for_each(part, begin, end, counted, threads, [](size_t) {}); });
+	}
+
+	/**
+	 * \brief Overload of the partitioned async_for_each without progress callback.
+	 */
+	template<partitioner Pt, typename I, typename F>
+	inline void 
+	async_for_each(Pt part, I begin, I end, F&& f, size_t threads = runtime_threads()) 
+	{
+		async_for_each(part, begin, end, std::forward<F>(f), threads, [](size_t) {});
+	}
+
+	namespace detail
+	{
+		template<typename T>
+		struct is_tuple_like : std::false_type {};
+
+		template<typename... Ts>
+		struct is_tuple_like<std::tuple<Ts...>> : std::true_type {};
+
+		template<typename A, typename B>
+		struct is_tuple_like<std::pair<A, B>> : std::true_type {};
+
+		/// True if `f` takes the element `V` whole, with or without index and thread id.
+		template<typename F, typename V>
+		inline constexpr bool takes_element_v = std::is_invocable_v<F, V> || std::is_invocable_v<F, V, size_t> 
+			|| std::is_invocable_v<F, V, size_t, size_t>;
+
+		/**
+		 * \brief Invoke the loop body with the unpacked fields of an element and as many of (index, thread id) as it accepts.
+		 */
+		template<typename F, typename... Xs>
+		inline void
+		invoke_unpacked(F& f, size_t idx, size_t thread_id, Xs&&... xs)
+		{
+			if constexpr (std::is_invocable_v<F, Xs..., size_t, size_t>)
+				f(std::forward<Xs>(xs)..., idx, thread_id);
+			else if constexpr (std::is_invocable_v<F, Xs..., size_t>)
+				f(std::forward<Xs>(xs)..., idx);
+			else if constexpr (std::is_invocable_v<F, Xs...>)
+				f(std::forward<Xs>(xs)...);
+			else
+				static_assert(false, "f must take the element, or its fields, optionally followed by (size_t) or (size_t, size_t)");
+		}
+
+		/**
+		 * \brief Loop body over the elements of `R`.
+		 *
+		 * Tuple elements, such as those of `std::views::zip`, are unpacked into 
+		 * separate arguments unless `f` takes the tuple itself.
+		 */
+		template<typename R, typename F>
+		inline auto
+		range_body(F& f)
+		{
+			using ref = std::ranges::range_reference_t<R>;
+			if constexpr (is_tuple_like<std::remove_cvref_t<ref>>::value && !takes_element_v<F, ref>)
+				return [&f](auto&& element, size_t idx, size_t id) -> void
+				{
+					std::apply([&](auto&&... xs) { invoke_unpacked(f, idx, id, std::forward<decltype(xs)>(xs)...); }, 
+						std::forward<decltype(element)>(element));
+				};
+			else
+				return [&f](auto&& element, size_t idx, size_t id) -> void
+				{
+					invoke(f, std::forward<decltype(element)>(element), idx, id);
+				};
+		}
+
+		/**
+		 * \brief `[first, last)` iterators of the random-access range `r`, also when its end is a different sentinel type.
+		 *
+		 * Splitting needs the length anyway; `next` is O(1) for sized sentinels.
+		 */
+		template<std::ranges::random_access_range R>
+		inline std::pair<std::ranges::iterator_t<R>, std::ranges::iterator_t<R>>
+		range_bounds(R& r)
+		{
+			auto first = std::ranges::begin(r);
+			if constexpr (std::ranges::common_range<R>)
+				return {first, std::ranges::end(r)};
+			else if constexpr (std::ranges::sized_range<R>)
+				return {first, first + std::ranges::distance(r)};
+			else
+				return {first, std::ranges::next(first, std::ranges::end(r))};
+		}
+	}
+
+	/**
+	 * \brief Parallel for-each over a range or view, split like its iterators.
+	 *
+	 * Accepts containers and `std::ranges` views such as `iota`, `transform`,
+	 * `chunk`, `stride` and `zip`; random-access views are split by the same
+	 * chunk logic as iterator pairs. Elements of a `zip` (or any range of tuples)
+	 * are passed as separate references, `f(a, b[, idx][, thread_id])`, so the 
+	 * body sees one contiguous stream per underlying array.
+	 *
+	 * \tparam Pt Partitioner type
+	 * \tparam R Range type
+	 * \tparam F Callable type
+	 * \param part Partitioning policy
+	 * \param range Range to iterate; must outlive the call
+	 * \param f Function to invoke on each element or its unpacked fields
+	 * \param threads Number of threads to use
+	 */
+	template<partitioner Pt, std::ranges::forward_range R, typename F>
+	inline void
+	async_for_each(Pt part, R&& range, F&& f, size_t threads = runtime_threads())
+	{
+		auto body = detail::range_body<R>(f);
+		if constexpr (!std::ranges::random_access_range<R>)
+		{
+			// The node cursor stops at the sentinel, so the range is walked once.
+			auto first = std::ranges::begin(range);
+			auto last = std::ranges::end(range);
+			if (first == last) return;
+			if constexpr (std::ranges::sized_range<R>)
+				threads = detail::cap_threads(threads, static_cast<size_t>(std::ranges::size(range)));
+			detail::error_state errors;
+			auto progress = [](size_t) {};
+			detail::cursor_for_each(first, last, detail::node_grain(part), body, threads, errors, progress);
+			errors.rethrow();
+		}
+		else
+		{
+			auto [first, last] = detail::range_bounds(range);
+			async_for_each(part, first, last, body, threads, [](size_t) {});
+		}
+	}
+
+	/**
+	 * \brief Parallel for-each over a range or view, static partitioning.
+	 * \see async_for_each(Pt, R&&, F&&, size_t)
+	 */
+	template<std::ranges::forward_range R, typename F>
+	inline void
+	async_for_each(R&& range, F&& f, size_t threads = runtime_threads())
+	{
+		async_for_each(static_partitioner{}, std::forward<R>(range), std::forward<F>(f), threads);
+	}
+
+	/**
+	 * \brief Tag selecting the error-aggregating overloads of `async_for_each`.
+	 */
+	struct aggregate_errors_t
+	{
+		explicit aggregate_errors_t() = default;
+	};
+
+	inline constexpr aggregate_errors_t aggregate_errors{};
+
+	/// Failures of an error-aggregating loop: (element index, exception), by index.
+	using element_errors = std::vector<std::pair<size_t, std::exception_ptr>>;
+
+	/**
+	 * \brief Parallel for-each that runs every element and collects each failure instead of stopping at the first.
+	 *
+	 * Each participant records the index and exception of its failing elements
+	 * in its own list, so failures cost no shared state; the lists are merged and
+	 * sorted by index after the join. Errors outside the body, such as from the
+	 * iterators, still abort the call and are rethrown.
+	 *
+	 * \tparam Pt Partitioner type
+	 * \param part Partitioning policy
+	 * \param begin Iterator to start of range
+	 * \param end Iterator to end of range
+	 * \param f Function to invoke on each element (can optionally take an index)
+	 * \param threads Number of threads to use
+	 * \return The failing elements' indices and exceptions, empty if none failed
+	 */
+	template<partitioner Pt, typename I, typename F>
+	inline element_errors
+	async_for_each(aggregate_errors_t, Pt part, I begin, I end, F&& f, size_t threads = runtime_threads())
+	{
+		std::vector<detail::padded<element_errors>> failures(std::max<size_t>(1, threads));
+
+		auto body = [&](auto&& value, size_t idx, size_t id) -> void
+		{
+			try
+			{
+				detail::invoke(f, std::forward<decltype(value)>(value), idx, id);
+			}
+			catch (...)
+			{
+				failures[id].value.emplace_back(idx, std::current_exception());
+			}
+		};
+
+		async_for_each(part, begin, end, body, threads, [](size_t) {});
+
+		element_errors errors;
+		for (auto& local : failures)
+			errors.insert(errors.end(), std::make_move_iterator(local.value.begin()), std::make_move_iterator(local.value.end()));
+		std::sort(errors.begin(), errors.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+		return errors;
+	}
+
+	/**
+	 * \brief Error-aggregating parallel for-each, static partitioning.
+	 * \see async_for_each(aggregate_errors_t, Pt, I, I, F&&, size_t)
+	 */
+	template<typename I, typename F>
+	inline element_errors
+	async_for_each(aggregate_errors_t tag, I begin, I end, F&& f, size_t threads = runtime_threads())
+	{
+		return async_for_each(tag, static_partitioner{}, begin, end, std::forward<F>(f), threads);
+	}
+
+	/**
+	 * \brief How a cancellable loop ended.
+	 */
+	enum class loop_status
+	{
+		completed, ///< Every element was processed
+		cancelled, ///< A stop was requested through the token
+		timed_out  ///< The deadline passed
+	};
+
+	/**
+	 * \brief Outcome of a cancellable loop.
+	 */
+	struct loop_result
+	{
+		loop_status status = loop_status::completed;
+		size_t processed = 0; ///< Elements processed before the loop stopped
+
+		/// True if the loop ran to completion.
+		explicit operator bool() const noexcept { return status == loop_status::completed; }
+	};
+
+	/**
+	 * \brief Cooperative cancellation of a loop, from outside and without throwing through `f`.
+	 */
+	struct cancellation
+	{
+		std::stop_token token;                          ///< Stops the loop once a stop is requested
+		std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+		size_t poll = 1024;                             ///< Elements each participant runs between polls
+	};
+
+	namespace detail
+	{
+		/**
+		 * \brief Polling of a `cancellation` shared by the participants of one loop.
+		 *
+		 * A stop raises the loop's abort flag, so the participants that are not
+		 * polling stop at their next element as on an exception.
+		 */
+		struct stop_state
+		{
+			const cancellation& cancel;
+			error_state& errors;
+			std::vector<padded<size_t>> countdown;
+			std::vector<padded<size_t>> processed;
+			alignas(64) std::atomic<loop_status> status{loop_status::completed};
+
+			stop_state(const cancellation& cancel, error_state& errors, size_t threads)
+				: cancel(cancel), errors(errors), countdown(threads), processed(threads)
+			{
+				for (auto& c : countdown)
+					c.value = std::max<size_t>(1, cancel.poll);
+			}
+
+			/// Check the token and the deadline now. \return true if the loop must stop
+			bool stop_now() noexcept
+			{
+				loop_status reason = loop_status::completed;
+				if (cancel.token.stop_requested())
+					reason = loop_status::cancelled;
+				else if (std::chrono::steady_clock::now() >= cancel.deadline)
+					reason = loop_status::timed_out;
+				else
+					return false;
+
+				loop_status expected = loop_status::completed;
+				status.compare_exchange_strong(expected, reason, std::memory_order_relaxed);
+				errors.stop();
+				return true;
+			}
+
+			/// Count one element of participant `id`, polling every `cancel.poll` elements. \return true if the loop must stop
+			bool tick(size_t id) noexcept
+			{
+				processed[id].value++;
+				if (--countdown[id].value != 0)
+					return false;
+				countdown[id].value = std::max<size_t>(1, cancel.poll);
+				return stop_now();
+			}
+
+			loop_result result() const noexcept
+			{
+				loop_result r{status.load(std::memory_order_relaxed), 0};
+				for (const auto& p : processed)
+					r.processed += p.value;
+				return r;
+			}
+		};
+	}
+
+	/**
+	 * \brief Cancellable parallel for-each with a selectable partitioning policy.
+	 *
+	 * Each participant polls `cancel.token` and `cancel.deadline` every 
+	 * `cancel.poll` elements; the first stop observed ends the loop, elements 
+	 * already started run to completion, and the result tells how the loop ended
+	 * and how many elements were processed. Exceptions from `f` are rethrown as
+	 * usual. The index passed to `f` is the element's offset from `begin`.
+	 *
+	 * \tparam Pt Partitioner type
+	 * \param cancel Stop token, deadline and polling interval
+	 * \param part Partitioning policy
+	 * \param begin Iterator to start of range
+	 * \param end Iterator to end of range
+	 * \param f Function to invoke on each element (can optionally take an index)
+	 * \param threads Number of threads to use
+	 * \return Status and the number of elements processed
+	 */
+	template<partitioner Pt, typename I, typename F>
+	inline loop_result
+	async_for_each(const cancellation& cancel, Pt part, I begin, I end, F&& f, size_t threads = runtime_threads())
+	{
+		detail::error_state errors;
+		threads = std::max<size_t>(1, threads);
+
+		if constexpr (!is_random_access_iterator_v<I>)
+		{
+			detail::stop_state stop(cancel, errors, threads);
+			if (begin == end || stop.stop_now()) return stop.result();
+
+			auto body = [&](I first, I last, size_t idx, size_t id)
+			{
+				for (auto it = first; it != last && !errors.aborted(); ++it)
+				{
+					detail::invoke(f, *it, idx++, id);
+					if (stop.tick(id)) break;
+				}
+			};
+			detail::run_cursor(begin, end, detail::node_grain(part), threads, errors, body, [](size_t) {});
+			errors.rethrow();
+			return stop.result();
+		}
+		else
+		{
+			size_t size = static_cast<size_t>(std::ranges::distance(begin, end));
+			threads = detail::cap_threads(threads, size);
+			detail::stop_state stop(cancel, errors, threads);
+			if (size == 0 || stop.stop_now()) return stop.result();
+
+			auto body = [&](size_t first, size_t last, size_t id)
+			{
+				auto it = std::ranges::next(begin, first);
+				for (size_t idx = first; idx < last && !errors.aborted(); ++idx, ++it)
+				{
+					detail::invoke(f, *it, idx, id);
+					if (stop.tick(id)) break;
+				}
+			};
+			detail::run_partitioned(part, size, threads, errors, body);
+			errors.rethrow();
+			return stop.result();
+		}
+	}
+
+	/**
+	 * \brief Cancellable parallel for-each, static partitioning.
+	 * \see async_for_each(const cancellation&, Pt, I, I, F&&, size_t)
+	 */
+	template<typename I, typename F>
+	inline loop_result
+	async_for_each(const cancellation& cancel, I begin, I end, F&& f, size_t threads = runtime_threads())
+	{
+		return async_for_each(cancel, static_partitioner{}, begin, end, std::forward<F>(f), threads);
+	}
+
+
+	namespace detail
+	{
+		/**
+		 * \brief View over elements `[first, last)` of the range starting at `begin`.
+		 *
+		 * A `std::span` for contiguous iterators, a `std::ranges::subrange` otherwise.
+		 */
+		template<std::random_access_iterator I>
+		inline auto
+		chunk_view(I begin, size_t first, size_t last)
+		{
+			if constexpr (std::contiguous_iterator<I>)
+				return std::span(std::to_address(begin) + first, last - first);
+			else
+				return std::ranges::subrange(std::ranges::next(begin, first), std::ranges::next(begin, last));
+		}
+	}
+
+	/**
+	 * \brief Parallel for-each over whole chunks with a selectable partitioning policy.
+	 *
+	 * `f` is invoked once per chunk, with the chunk as a `std::span` (contiguous 
+	 * iterators) or `std::ranges::subrange`, the index of its first element and
+	 * the thread id, so per-chunk setup is hoisted out of the element loop and the
+	 * inner loop can be written, and vectorised, by the caller. Iterators that are
+	 * not random access get a `std::ranges::subrange` per batch of nodes pulled
+	 * from a shared cursor.
+	 *
+	 * \tparam Pt Partitioner type
+	 * \param part Partitioning policy
+	 * \param begin Iterator to start of range
+	 * \param end Iterator to end of range
+	 * \param f Function invoked as `f(chunk)`, `f(chunk, first_index)` or `f(chunk, first_index, thread_id)`
+	 * \param threads Number of threads to use
+	 */
+	template<partitioner Pt, typename I, typename F>
+	inline void 
+	async_for_each_chunk(Pt part, I begin, I end, F&& f, size_t threads = runtime_threads())
+	{
+		detail::error_state errors;
+
+		if constexpr (!is_random_access_iterator_v<I>)
+		{
+			if (begin == end) return;
+			auto body = [&](I first, I last, size_t first_index, size_t id)
+			{
+				detail::invoke(f, std::ranges::subrange(first, last), first_index, id);
+			};
+			detail::run_cursor(begin, end, detail::node_grain(part), threads, errors, body, [](size_t) {});
+		}
+		else
+		{
+			size_t size = static_cast<size_t>(std::ranges::distance(begin, end));
+			if (size == 0) return;
+			threads = detail::cap_threads(threads, size);
+			auto sched = detail::make_schedule(part, size, threads, errors);
+
+			auto body = [&](size_t first, size_t last, size_t id)
+			{
+				detail::invoke(f, detail::chunk_view(begin, first, last), first, id);
+			};
+
+			auto finish = [](size_t) {};
+
+			detail::run_schedule(sched, threads, errors, body, finish);
+		}
+
+		errors.rethrow();
+	}
+
+	/**
+	 * \brief Parallel for-each over whole chunks, static partitioning.
+	 * \see async_for_each_chunk
+	 */
+	template<typename I, typename F>
+	inline void 
+	async_for_each_chunk(I begin, I end, F&& f, size_t threads = runtime_threads())
+	{
+		async_for_each_chunk(static_partitioner{}, begin, end, std::forward<F>(f), threads);
+	}
+
+	/**
+	 * \brief Tile shape of `async_for_each_2d`, in rows and columns.
+	 */
+	struct tile_2d
+	{
+		size_t rows = 32;
+		size_t cols = 32;
+	};
+
+	/**
+	 * \brief Tile shape of `async_for_each_3d`, in planes, rows and columns.
+	 */
+	struct tile_3d
+	{
+		size_t depth = 8;
+		size_t rows = 8;
+		size_t cols = 32;
+	};
+
+	namespace detail
+	{
+		/**
+		 * \brief Invoke a `N`-dimensional loop body with the indices and, if it accepts one, the thread id.
+		 */
+		template<size_t N, typename F, typename... Ix>
+		inline void
+		invoke_nd(F& f, size_t thread_id, Ix... idx)
+		{
+			if constexpr (std::is_invocable_v<F, Ix..., size_t>)
+				f(idx..., thread_id);
+			else if constexpr (std::is_invocable_v<F, Ix...>)
+				f(idx...);
+			else
+				static_assert(false, "f must be invocable with the N indices, optionally followed by the thread id");
+		}
+
+		/**
+		 * \brief Run `f` over the box `[lo, hi)`, the last dimension innermost.
+		 */
+		template<size_t N, typename F>
+		inline void
+		for_each_box(F& f, const std::array<size_t, N>& lo, const std::array<size_t, N>& hi, size_t thread_id)
+		{
+			static_assert(N == 2 || N == 3, "only 2D and 3D index spaces are supported");
+			if constexpr (N == 2)
+			{
+				for (size_t i = lo[0]; i < hi[0]; ++i)
+					for (size_t j = lo[1]; j < hi[1]; ++j)
+						invoke_nd<2>(f, thread_id, i, j);
+			}
+			else
+			{
+				for (size_t i = lo[0]; i < hi[0]; ++i)
+					for (size_t j = lo[1]; j < hi[1]; ++j)
+						for (size_t k = lo[2]; k < hi[2]; ++k)
+							invoke_nd<3>(f, thread_id, i, j, k);
+			}
+		}
+
+		/**
+		 * \brief Bounds of tile `t` of the row-major tile grid over `extent`.
+		 */
+		template<size_t N>
+		inline void
+		tile_bounds(size_t t, const std::array<size_t, N>& extent, const std::array<size_t, N>& tile,
+					std::array<size_t, N>& lo, std::array<size_t, N>& hi) noexcept
+		{
+			for (size_t d = N; d-- > 0;)
+			{
+				size_t tiles = (extent[d] + tile[d] - 1) / tile[d];
+				lo[d] = (t % tiles) * tile[d];
+				hi[d] = std::min(lo[d] + tile[d], extent[d]);
+				t /= tiles;
+			}
+		}
+
+		/**
+		 * \brief Split the tiles of `extent` with `part` and run `f` over each tile.
+		 */
+		template<size_t N, typename Pt, typename F>
+		inline void
+		for_each_tiled(Pt part, const std::array<size_t, N>& extent, std::array<size_t, N> tile, F& f, size_t threads)
+		{
+			size_t tiles = 1;
+			for (size_t d = 0; d < N; ++d)
+			{
+				if (extent[d] == 0) return;
+				tile[d] = std::clamp<size_t>(tile[d], 1, extent[d]);
+				tiles *= (extent[d] + tile[d] - 1) / tile[d];
+			}
+
+			error_state errors;
+			auto body = [&](size_t first, size_t last, size_t id)
+			{
+				std::array<size_t, N> lo, hi;
+				for (size_t t = first; t < last && !errors.aborted(); ++t)
+				{
+					tile_bounds<N>(t, extent, tile, lo, hi);
+					for_each_box<N>(f, lo, hi, id);
+				}
+			};
+
+			run_partitioned(part, tiles, cap_threads(threads, tiles), errors, body);
+			errors.rethrow();
+		}
+	}
+
+	/**
+	 * \brief Parallel loop over the 2D index space `[0, rows) x [0, cols)`, split into tiles.
+	 *
+	 * The tiles of the row-major tile grid are split by `part` as a loop over
+	 * tiles is; each tile runs row by row, so a participant works on compact
+	 * blocks of rows and columns instead of long strips of a flattened loop.
+	 * `f` is invoked as `f(i, j)` or `f(i, j, thread_id)`.
+	 *
+	 * \tparam Pt Partitioner type
+	 * \tparam F Callable type
+	 * \param part Partitioning policy, applied to tiles
+	 * \param rows Extent of `i`
+	 * \param cols Extent of `j`, the innermost index
+	 * \param f Function to invoke on each index pair
+	 * \param tile Tile shape, clamped to the index space
+	 * \param threads Number of threads to use
+	 */
+	template<partitioner Pt, typename F>
+	inline void
+	async_for_each_2d(Pt part, size_t rows, size_t cols, F&& f, tile_2d tile = {}, size_t threads = runtime_threads())
+	{
+		detail::for_each_tiled<2>(part, {rows, cols}, {tile.rows, tile.cols}, f, threads);
+	}
+
+	/**
+	 * \brief Tiled 2D loop, static partitioning of the tiles.
+	 * \see async_for_each_2d(Pt, size_t, size_t, F&&, tile_2d, size_t)
+	 */
+	template<typename F>
+	inline void
+	async_for_each_2d(size_t rows, size_t cols, F&& f, tile_2d tile = {}, size_t threads = runtime_threads())
+	{
+		async_for_each_2d(static_partitioner{}, rows, cols, std::forward<F>(f), tile, threads);
+	}
+
+	/**
+	 * \brief Parallel loop over the 3D index space `[0, depth) x [0, rows) x [0, cols)`, split into tiles.
+	 *
+	 * As `async_for_each_2d`, with `f` invoked as `f(i, j, k)` or `f(i, j, k, thread_id)`.
+	 *
+	 * \tparam Pt Partitioner type
+	 * \tparam F Callable type
+	 * \param part Partitioning policy, applied to tiles
+	 * \param depth Extent of `i`
+	 * \param rows Extent of `j`
+	 * \param cols Extent of `k`, the innermost index
+	 * \param f Function to invoke on each index triple
+	 * \param tile Tile shape, clamped to the index space
+	 * \param threads Number of threads to use
+	 */
+	template<partitioner Pt, typename F>
+	inline void
+	async_for_each_3d(Pt part, size_t depth, size_t rows, size_t cols, F&& f, tile_3d tile = {}, 
+						size_t threads = runtime_threads())
+	{
+		detail::for_each_tiled<3>(part, {depth, rows, cols}, {tile.depth, tile.rows, tile.cols}, f, threads);
+	}
+
+	/**
+	 * \brief Tiled 3D loop, static partitioning of the tiles.
+	 * \see async_for_each_3d(Pt, size_t, size_t, size_t, F&&, tile_3d, size_t)
+	 */
+	template<typename F>
+	inline void
+	async_for_each_3d(size_t depth, size_t rows, size_t cols, F&& f, tile_3d tile = {}, size_t threads = runtime_threads())
+	{
+		async_for_each_3d(static_partitioner{}, depth, rows, cols, std::forward<F>(f), tile, threads);
+	}
+
+	/**
+	 * \brief Construct copies of `value` in uninitialised storage, NUMA first-touch style.
+	 *
+	 * Elements are constructed with the chunking and placement of `numa_partitioner`,
+	 * so under a first-touch memory policy the pages of each slice are allocated on
+	 * the node whose workers later process it with the same partitioner and thread
+	 * count. The storage must not have been written yet, e.g. from 
+	 * `std::make_unique_for_overwrite<T[]>(n)`; a `std::vector` touches its
+	 * elements on construction.
+	 *
+	 * \param begin Contiguous iterator to start of uninitialised storage
+	 * \param end Contiguous iterator to end of uninitialised storage
+	 * \param value Value to copy into every element
+	 * \param threads Number of threads to use
+	 */
+	template<std::contiguous_iterator I, typename T>
+	inline void
+	async_first_touch(I begin, I end, const T& value, size_t threads = runtime_threads())
+	{
+		async_for_each_chunk(numa_partitioner{}, begin, end,
+			[&value](auto chunk)
+			{
+				std::uninitialized_fill(chunk.begin(), chunk.end(), value);
+			}, threads);
+	}
+
+	namespace detail
+	{
+		/**
+		 * \brief Shared state of a loop launched without joining.
+		 *
+		 * Owned jointly by the loop's pool tasks and its `loop_handle`; the last
+		 * participant to return marks the loop done and resumes the coroutine 
+		 * awaiting it, if any, on its own thread.
+		 */
+		struct loop_state
+		{
+			error_state errors;
+			alignas(64) std::atomic<size_t> pending{0};
+			std::mutex mutex;
+			std::condition_variable cv;
+			bool done = false;
+			std::coroutine_handle<> continuation; ///< Coroutine awaiting the loop, if any
+
+			virtual ~loop_state() = default;
+
+			/**
+			 * \brief Arrange for `awaiter` to be resumed on completion.
+			 * \return false if the loop has already completed
+			 */
+			bool suspend(std::coroutine_handle<> awaiter)
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				if (done) return false;
+				continuation = awaiter;
+				return true;
+			}
+
+			/// Body of participant `id`.
+			virtual void run(size_t id) = 0;
+
+			/// Run participant `id`, recording its exception, and complete the loop if it is the last.
+			void participate(size_t id) noexcept
+			{
+				try
+				{
+					run(id);
+				}
+				catch (...)
+				{
+					errors.capture();
+				}
+
+				if (pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+				{
+					std::coroutine_handle<> awaiter;
+					{
+						std::lock_guard<std::mutex> lock(mutex);
+						done = true;
+						awaiter = std::exchange(continuation, {});
+					}
+					cv.notify_all();
+					if (awaiter)
+						awaiter.resume();
+				}
+			}
+		};
+
+		/**
+		 * \brief Queue `n` participants of `state` on the pool, participant `i` on worker `place(i)`.
+		 */
+		template<typename W>
+		inline void
+		launch(const std::shared_ptr<loop_state>& state, size_t n, W&& place)
+		{
+			thread_pool& pool = thread_pool::instance();
+			state->pending.store(n, std::memory_order_relaxed);
+
+			for (size_t i = 0; i < n; ++i)
+			{
+				size_t worker = place(i);
+				auto task = [state, i] { state->participate(i); };
+				if (worker == no_worker)
+					pool.submit(std::move(task));
+				else
+					pool.submit_to(worker, std::move(task));
+			}
+		}
+
+		/// A partitioned for-each run by a `loop_state`.
+		template<typename S, typename I, typename F>
+		struct launched_for_each : loop_state
+		{
+			S sched;
+			I begin;
+			F f;
+
+			template<typename Pt>
+			launched_for_each(Pt part, I begin, size_t size, size_t threads, F f)
+				: sched(make_schedule(part, size, threads, errors)), begin(begin), f(std::move(f))
+			{
+			}
+
+			void run(size_t id) override
+			{
+				index_range r{0, 0};
+				while ((nothrow_body_v<F&, std::iter_reference_t<I>> || !errors.aborted()) && sched.next(id, r))
+				{
+					for_each_range(begin, r.first, r.last, f, id, errors);
+					sched.done(r);
+					yield_to_urgent();
+				}
+			}
+		};
+
+		/// A blocking call run as a single participant of a `loop_state`.
+		template<typename C>
+		struct launched_call : loop_state
+		{
+			C call;
+
+			explicit launched_call(C call) : call(std::move(call)) {}
+
+			void run(size_t) override { call(); }
+		};
+	}
+
+	/**
+	 * \brief Handle to a parallel loop running in the background.
+	 *
+	 * Returned by `async_launch_for_each`. Like a `std::future` from `std::async`,
+	 * destroying a handle whose loop is still running blocks until it completes.
+	 */
+	class loop_handle
+	{
+	public:
+		loop_handle() = default;
+
+		explicit loop_handle(std::shared_ptr<detail::loop_state> state) noexcept
+			: _state(std::move(state))
+		{
+		}
+
+		loop_handle(loop_handle&&) noexcept = default;
+
+		loop_handle& operator=(loop_handle&& other) noexcept
+		{
+			if (this != &other)
+			{
+				join();
+				_state = std::move(other._state);
+			}
+			return *this;
+		}
+
+		~loop_handle() { join(); }
+
+		/// True if the handle refers to a loop.
+		bool valid() const noexcept { return _state != nullptr; }
+
+		/// True once every participant of the loop has returned.
+		bool is_ready() const
+		{
+			std::lock_guard<std::mutex> lock(_state->mutex);
+			return _state->done;
+		}
+
+		/**
+		 * \brief Wait at most `timeout` for the loop to complete.
+		 * \return true if the loop has completed
+		 */
+		template<typename Rep, typename Period>
+		bool wait_for(const std::chrono::duration<Rep, Period>& timeout) const
+		{
+			std::unique_lock<std::mutex> lock(_state->mutex);
+			return _state->cv.wait_for(lock, timeout, [this] { return _state->done; });
+		}
+
+		/**
+		 * \brief Wait for the loop to complete, running queued pool tasks meanwhile.
+		 *
+		 * Rethrows the first exception raised by the loop, as the blocking calls do.
+		 */
+		void wait()
+		{
+			join();
+			_state->errors.rethrow();
+		}
+
+		/**
+		 * \brief Suspend the awaiting coroutine until the loop completes.
+		 *
+		 * The coroutine resumes on the pool worker that finished the loop, and
+		 * `co_await` rethrows the loop's first exception.
+		 */
+		auto operator co_await() const noexcept
+		{
+			struct awaiter
+			{
+				detail::loop_state* state;
+
+				bool await_ready() const noexcept { return false; }
+				bool await_suspend(std::coroutine_handle<> h) { return state->suspend(h); }
+				void await_resume() const { state->errors.rethrow(); }
+			};
+			return awaiter{_state.get()};
+		}
+
+	private:
+		void join() noexcept
+		{
+			if (!_state) return;
+			thread_pool& pool = thread_pool::instance();
+			while (!is_ready())
+				if (!pool.try_run_one())
+				{
+					std::unique_lock<std::mutex> lock(_state->mutex);
+					_state->cv.wait(lock, [this] { return _state->done; });
+				}
+		}
+
+		std::shared_ptr<detail::loop_state> _state;
+	};
+
+	/**
+	 * \brief Start a partitioned parallel for-each and return without waiting for it.
+	 *
+	 * The loop runs on the pool as `async_for_each(part, ...)` would, while the caller
+	 * continues; any number of launched loops may be in flight at once. `f` is
+	 * copied into the loop, which must not outlive the range.
+	 *
+	 * \tparam Pt Partitioner type
+	 * \param part Partitioning policy
+	 * \param begin Iterator to start of range
+	 * \param end Iterator to end of range
+	 * \param f Function to invoke on each element (can optionally take an index)
+	 * \param threads Number of threads to use
+	 * \return Handle to wait on the loop
+	 */
+	template<partitioner Pt, typename I, typename F>
+	inline loop_handle
+	async_launch_for_each(Pt part, I begin, I end, F f, size_t threads = runtime_threads())
+	{
+		std::shared_ptr<detail::loop_state> state;
+		auto finished = []
+		{
+			auto call = [] {};
+			auto done = std::make_shared<detail::launched_call<decltype(call)>>(call);
+			done->done = true;
+			return done;
+		};
+
+		if constexpr (!is_random_access_iterator_v<I>)
+		{
+			// No up-front length: the walk happens on the pool, through the node cursor.
+			if (begin == end)
+				return loop_handle(finished());
+
+			auto call = [=]() mutable { async_for_each(part, begin, end, f, threads); };
+			state = std::make_shared<detail::launched_call<decltype(call)>>(std::move(call));
+			detail::launch(state, 1, [](size_t) { return detail::no_worker; });
+		}
+		else
+		{
+			size_t size = static_cast<size_t>(std::ranges::distance(begin, end));
+			if (size == 0)
+				return loop_handle(finished());
+			threads = detail::cap_threads(threads, size);
+
+			using schedule = decltype(detail::make_schedule(part, size, threads, std::declval<detail::error_state&>()));
+			auto loop = std::make_shared<detail::launched_for_each<schedule, I, F>>(part, begin, size, threads, std::move(f));
+
+			if constexpr (requires { loop->sched.place(size_t{}); })
+				detail::launch(loop, threads, [loop](size_t id) { return loop->sched.place(id); });
+			else
+				detail::launch(loop, threads, [](size_t) { return detail::no_worker; });
+			state = std::move(loop);
+		}
+
+		return loop_handle(std::move(state));
+	}
+
+	/**
+	 * \brief Start a statically partitioned parallel for-each and return without waiting for it.
+	 * \see async_launch_for_each
+	 */
+	template<typename I, typename F>
+	inline loop_handle
+	async_launch_for_each(I begin, I end, F f, size_t threads = runtime_threads())
+	{
+		return async_launch_for_each(static_partitioner{}, begin, end, std::move(f), threads);
+	}
+
+	namespace detail
+	{
+		/**
+		 * \brief Fold `transform` of elements `[first, last)` of the range at `begin` into `partial`.
+		 *
+		 * The range is accumulated in a local, so `partial` is written once.
+		 */
+		template<typename I, typename T, typename Op, typename U>
+		inline void
+		reduce_range(I begin, size_t first, size_t last, std::optional<T>& partial, Op& op, U& transform)
+		{
+			auto it = std::ranges::next(begin, first);
+			auto it_end = std::ranges::next(it, last - first);
+
+			T acc = partial ? op(std::move(*partial), transform(*it)) : static_cast<T>(transform(*it));
+			for (++it; it != it_end; ++it)
+				acc = op(std::move(acc), transform(*it));
+			partial = std::move(acc);
+		}
+
+		/**
+		 * \brief Combine `init` with the non-empty partials, in participant order.
+		 */
+		template<typename T, typename Op>
+		inline T
+		combine(T init, std::vector<padded<std::optional<T>>>& partials, Op& op)
+		{
+			for (auto& partial : partials)
+				if (partial.value)
+					init = op(std::move(init), std::move(*partial.value));
+			return init;
+		}
+
+		/**
+		 * \brief Reduce `transform(*(begin + i))` over the ranges of `sched` into per-participant partials.
+		 *
+		 * Each range is accumulated in a local before being folded into its participant's
+		 * partial; the partials are combined with `init`, in participant order, at the join.
+		 */
+		template<typename S, typename I, typename T, typename Op, typename U>
+		inline T
+		transform_reduce(S& sched, size_t threads, error_state& errors, I begin, T init, Op& op, U& transform)
+		{
+			std::vector<padded<std::optional<T>>> partials(threads);
+
+			auto body = [&](size_t first, size_t last, size_t id)
+			{
+				reduce_range(begin, first, last, partials[id].value, op, transform);
+			};
+
+			auto finish = [](size_t) {};
+
+			run_schedule(sched, threads, errors, body, finish);
+			errors.rethrow();
+
+			return combine(std::move(init), partials, op);
+		}
+	}
+
+	/**
+	 * \brief Parallel transform-reduce over a range with a selectable partitioning policy.
+	 * 
+	 * Elements are accumulated into per-thread, cache-line padded partials which
+	 * are combined once at the join, so `op` needs no synchronisation. `op` must be
+	 * associative, and also commutative unless the static partitioner is used
+	 * over random access iterators.
+	 * Cancellation on exception is checked between ranges, not between elements.
+	 *
+	 * \tparam Pt Partitioner type
+	 * \tparam I Iterator type
+	 * \tparam T Result type
+	 * \tparam Op Binary reduction type
+	 * \tparam U Unary transform type
+	 * \param part Partitioning policy
+	 * \param begin Iterator to start of range
+	 * \param end Iterator to end of range
+	 * \param init Initial value, combined once with the partials
+	 * \param op Reduction, invocable as `op(T, T)` and `op(T, transform(*it))`
+	 * \param transform Function applied to every element before reduction
+	 * \param threads Number of threads to use
+	 * \return `init` combined with the reduction of every transformed element
+	 */
+	template<partitioner Pt, typename I, typename T, typename Op, typename U>
+	inline T
+	async_transform_reduce(Pt part, I begin, I end, T init, Op op, U transform, size_t threads = runtime_threads())
+	{
+		if constexpr (!is_random_access_iterator_v<I>)
+		{
+			if (begin == end) return init;
+			threads = std::max<size_t>(1, threads);
+			std::vector<detail::padded<std::optional<T>>> partials(threads);
+
+			async_for_each(part, begin, end, 
+				[&](auto&& value, size_t, size_t id)
+				{
+					std::optional<T>& partial = partials[id].value;
+					if (partial)
+						partial = op(std::move(*partial), transform(value));
+					else
+						partial = static_cast<T>(transform(value));
+				}, threads);
+
+			return detail::combine(std::move(init), partials, op);
+		}
+		else
+		{
+			size_t size = static_cast<size_t>(std::ranges::distance(begin, end));
+			if (size == 0) return init;
+			threads = detail::cap_threads(threads, size);
+
+			detail::error_state errors;
+			auto sched = detail::make_schedule(part, size, threads, errors);
+			return detail::transform_reduce(sched, threads, errors, begin, std::move(init), op, transform);
+		}
+	}
+
+	/**
+	 * \brief Parallel transform-reduce over a range, static partitioning.
+	 */
+	template<typename I, typename T, typename Op, typename U>
+	inline T
+	async_transform_reduce(I begin, I end, T init, Op op, U transform, size_t threads = runtime_threads())
+	{
+		return async_transform_reduce(static_partitioner{}, begin, end, std::move(init), 
+			std::move(op), std::move(transform), threads);
+	}
+
+	/**
+	 * \brief Parallel reduction over a range with a selectable partitioning policy.
+	 * \see async_transform_reduce
+	 */
+	template<partitioner Pt, typename I, typename T, typename Op = std::plus<>>
+	inline T
+	async_reduce(Pt part, I begin, I end, T init, Op op = {}, size_t threads = runtime_threads())
+	{
+		return async_transform_reduce(part, begin, end, std::move(init), std::move(op), 
+			std::identity{}, threads);
+	}
+
+	/**
+	 * \brief Parallel reduction over a range, static partitioning.
+	 * \see async_transform_reduce
+	 */
+	template<typename I, typename T, typename Op = std::plus<>>
+	inline T
+	async_reduce(I begin, I end, T init, Op op = {}, size_t threads = runtime_threads())
+	{
+		return async_transform_reduce(static_partitioner{}, begin, end, std::move(init), 
+			std::move(op), std::identity{}, threads);
+	}
+
+	namespace detail
+	{
+		/**
+		 * \brief Two-pass parallel scan over static chunks.
+		 *
+		 * The first pass reduces each chunk, the chunk totals are scanned serially,
+		 * and the second pass scans each chunk seeded with its offset, writing the
+		 * output directly so no separate fixup pass is needed. Without `init` the
+		 * scan is inclusive, otherwise exclusive.
+		 */
+		template<typename I, typename O, typename T, typename Op>
+		inline O
+		scan(I first, I last, O d_first, std::optional<T> init, Op& op, size_t threads)
+		{
+			size_t size = static_cast<size_t>(std::ranges::distance(first, last));
+			if (size == 0) return d_first;
+			threads = detail::cap_threads(threads, size);
+
+			const bool inclusive = !init.has_value();
+			error_state errors;
+			static_schedule sched{size, threads};
+			std::vector<padded<std::optional<T>>> partials(threads);
+
+			auto reduce = [&](size_t begin, size_t end, size_t id)
+			{
+				auto it = std::ranges::next(first, begin);
+				auto it_end = std::ranges::next(first, end);
+				T acc = *it;
+				for (++it; it != it_end; ++it)
+					acc = op(std::move(acc), *it);
+				partials[id].value = std::move(acc);
+			};
+
+			auto finish = [](size_t) {};
+
+			if (threads > 1)
+			{
+				run_schedule(sched, threads, errors, reduce, finish);
+				errors.rethrow();
+			}
+
+			// Exclusive prefix of the chunk totals: partials[i] becomes the seed of chunk i.
+			std::optional<T> carry = std::move(init);
+			for (auto& partial : partials)
+			{
+				std::optional<T> total = std::move(partial.value);
+				partial.value = carry;
+				if (total)
+					carry = carry ? op(std::move(*carry), std::move(*total)) : std::move(*total);
+			}
+
+			auto scan_chunk = [&](size_t begin, size_t end, size_t id)
+			{
+				auto it = std::ranges::next(first, begin);
+				auto it_end = std::ranges::next(first, end);
+				auto out = std::ranges::next(d_first, begin);
+				std::optional<T>& seed = partials[id].value;
+
+				T acc = seed ? std::move(*seed) : static_cast<T>(*it);
+				if (inclusive)
+				{
+					if (seed) acc = op(std::move(acc), *it);
+					*out = acc;
+					for (++it, ++out; it != it_end; ++it, ++out)
+					{
+						acc = op(std::move(acc), *it);
+						*out = acc;
+					}
+				}
+				else
+				{
+					for (; it != it_end; ++it, ++out)
+					{
+						T value = *it; // read before write, for in-place scans
+						*out = acc;
+						acc = op(std::move(acc), std::move(value));
+					}
+				}
+			};
+
+			run_schedule(sched, threads, errors, scan_chunk, finish);
+			errors.rethrow();
+
+			return std::ranges::next(d_first, size);
+		}
+	}
+
+	/**
+	 * \brief Parallel inclusive prefix scan, `d_first[i] = op(first[0], ..., first[i])`.
+	 * 
+	 * Two passes over the input: a per-chunk reduction, then a per-chunk scan 
+	 * seeded with the scanned chunk totals. `op` must be associative. The output
+	 * may alias the input.
+	 *
+	 * \tparam I Random access input iterator type
+	 * \tparam O Random access output iterator type
+	 * \tparam Op Binary operation type
+	 * \param first Iterator to start of input range
+	 * \param last Iterator to end of input range
+	 * \param d_first Iterator to start of output range
+	 * \param op Binary operation
+	 * \param threads Number of threads to use
+	 * \return Iterator past the last element written
+	 */
+	template<std::random_access_iterator I, std::random_access_iterator O, typename Op = std::plus<>>
+	inline O
+	async_inclusive_scan(I first, I last, O d_first, Op op = {}, size_t threads = runtime_threads())
+	{
+		using T = typename std::iterator_traits<I>::value_type;
+		return detail::scan<I, O, T>(first, last, d_first, std::nullopt, op, threads);
+	}
+
+	/**
+	 * \brief Parallel exclusive prefix scan, `d_first[i] = op(init, first[0], ..., first[i - 1])`.
+	 * \see async_inclusive_scan
+	 */
+	template<std::random_access_iterator I, std::random_access_iterator O, typename T, typename Op = std::plus<>>
+	inline O
+	async_exclusive_scan(I first, I last, O d_first, T init, Op op = {}, size_t threads = runtime_threads())
+	{
+		return detail::scan<I, O, T>(first, last, d_first, std::move(init), op, threads);
+	}
+
+	namespace detail
+	{
+		/// Elements per sorted run below which `async_sort` stops splitting.
+		inline constexpr size_t sort_grain = 4096;
+
+		/**
+		 * \brief Number of elements of `a[0, m)` among the first `d` of the stable merge with `b[0, n)`.
+		 *
+		 * Binary search along the merge path, so a merge can be cut into 
+		 * independent pieces of equal output length.
+		 */
+		template<typename A, typename B, typename C>
+		inline size_t
+		merge_split(A a, size_t m, B b, size_t n, size_t d, C& comp)
+		{
+			size_t lo = d > n ? d - n : 0;
+			size_t hi = std::min(d, m);
+			while (lo < hi)
+			{
+				size_t mid = lo + (hi - lo) / 2;
+				if (!comp(b[d - mid - 1], a[mid]))
+					lo = mid + 1;
+				else
+					hi = mid;
+			}
+			return lo;
+		}
+	}
+
+	/**
+	 * \brief Parallel `std::transform`, `d_first[i] = op(first[i])`, with a selectable partitioning policy.
+	 *
+	 * Each range is handed to `std::transform`, which keeps the inner loop 
+	 * vectorisable. The output may alias the input.
+	 *
+	 * \tparam Pt Partitioner type
+	 * \param part Partitioning policy
+	 * \param first Iterator to start of input range
+	 * \param last Iterator to end of input range
+	 * \param d_first Iterator to start of output range
+	 * \param op Unary operation
+	 * \param threads Number of threads to use
+	 * \return Iterator past the last element written
+	 */
+	template<partitioner Pt, std::random_access_iterator I, std::random_access_iterator O, typename Op>
+		requires std::invocable<Op&, std::iter_reference_t<I>>
+	inline O
+	async_transform(Pt part, I first, I last, O d_first, Op op, size_t threads = runtime_threads())
+	{
+		size_t size = static_cast<size_t>(std::ranges::distance(first, last));
+		if (size == 0) return d_first;
+		threads = detail::cap_threads(threads, size);
+
+		detail::error_state errors;
+		auto body = [&](size_t begin, size_t end, size_t)
+		{
+			std::transform(std::ranges::next(first, begin), std::ranges::next(first, end), 
+				std::ranges::next(d_first, begin), op);
+		};
+		detail::run_partitioned(part, size, threads, errors, body);
+		errors.rethrow();
+
+		return std::ranges::next(d_first, size);
+	}
+
+	/**
+	 * \brief Parallel binary `std::transform`, `d_first[i] = op(first1[i], first2[i])`.
+	 * \see async_transform
+	 */
+	template<partitioner Pt, std::random_access_iterator I1, std::random_access_iterator I2, 
+		std::random_access_iterator O, typename Op>
+		requires std::invocable<Op&, std::iter_reference_t<I1>, std::iter_reference_t<I2>>
+	inline O
+	async_transform(Pt part, I1 first1, I1 last1, I2 first2, O d_first, Op op, size_t threads = runtime_threads())
+	{
+		size_t size = static_cast<size_t>(std::ranges::distance(first1, last1));
+		if (size == 0) return d_first;
+		threads = detail::cap_threads(threads, size);
+
+		detail::error_state errors;
+		auto body = [&](size_t begin, size_t end, size_t)
+		{
+			std::transform(std::ranges::next(first1, begin), std::ranges::next(first1, end), 
+				std::ranges::next(first2, begin), std::ranges::next(d_first, begin), op);
+		};
+		detail::run_partitioned(part, size, threads, errors, body);
+		errors.rethrow();
+
+		return std::ranges::next(d_first, size);
+	}
+
+	/**
+	 * \brief Parallel unary `std::transform`, static partitioning.
+	 * \see async_transform
+	 */
+	template<std::random_access_iterator I, std::random_access_iterator O, typename Op>
+		requires std::invocable<Op&, std::iter_reference_t<I>>
+	inline O
+	async_transform(I first, I last, O d_first, Op op, size_t threads = runtime_threads())
+	{
+		return async_transform(static_partitioner{}, first, last, d_first, std::move(op), threads);
+	}
+
+	/**
+	 * \brief Parallel binary `std::transform`, static partitioning.
+	 * \see async_transform
+	 */
+	template<std::random_access_iterator I1, std::random_access_iterator I2, std::random_access_iterator O, typename Op>
+		requires std::invocable<Op&, std::iter_reference_t<I1>, std::iter_reference_t<I2>>
+	inline O
+	async_transform(I1 first1, I1 last1, I2 first2, O d_first, Op op, size_t threads = runtime_threads())
+	{
+		return async_transform(static_partitioner{}, first1, last1, first2, d_first, std::move(op), threads);
+	}
+
+	/**
+	 * \brief Parallel `std::fill` with a selectable partitioning policy.
+	 *
+	 * Under `numa_partitioner` each range is written by a worker on the node its
+	 * chunk is placed on; see `async_first_touch` for uninitialised memory.
+	 */
+	template<partitioner Pt, std::random_access_iterator I, typename T>
+	inline void
+	async_fill(Pt part, I first, I last, const T& value, size_t threads = runtime_threads())
+	{
+		size_t size = static_cast<size_t>(std::ranges::distance(first, last));
+		if (size == 0) return;
+		threads = detail::cap_threads(threads, size);
+
+		detail::error_state errors;
+		auto body = [&](size_t begin, size_t end, size_t)
+		{
+			std::fill(std::ranges::next(first, begin), std::ranges::next(first, end), value);
+		};
+		detail::run_partitioned(part, size, threads, errors, body);
+		errors.rethrow();
+	}
+
+	/**
+	 * \brief Parallel `std::fill`, static partitioning.
+	 */
+	template<std::random_access_iterator I, typename T>
+	inline void
+	async_fill(I first, I last, const T& value, size_t threads = runtime_threads())
+	{
+		async_fill(static_partitioner{}, first, last, value, threads);
+	}
+
+	/**
+	 * \brief Parallel `std::copy_if`, keeping the relative order of the copied elements.
+	 *
+	 * Scan-based compaction: each chunk evaluates `pred` once per element and 
+	 * counts its matches, an exclusive scan of the counts gives every chunk its
+	 * output offset, and the chunks then copy their marked elements in parallel.
+	 * The output must not overlap the input.
+	 *
+	 * \param first Iterator to start of input range
+	 * \param last Iterator to end of input range
+	 * \param d_first Iterator to start of output range
+	 * \param pred Predicate selecting the elements to copy
+	 * \param threads Number of threads to use
+	 * \return Iterator past the last element written
+	 */
+	template<std::random_access_iterator I, std::random_access_iterator O, typename Pred>
+	inline O
+	async_copy_if(I first, I last, O d_first, Pred pred, size_t threads = runtime_threads())
+	{
+		size_t size = static_cast<size_t>(std::ranges::distance(first, last));
+		if (size == 0) return d_first;
+		threads = detail::cap_threads(threads, size);
+
+		detail::error_state errors;
+		detail::static_schedule sched{size, threads};
+		std::vector<unsigned char> keep(size);
+		std::vector<detail::padded<size_t>> offsets(threads);
+		auto finish = [](size_t) {};
+
+		auto mark = [&](size_t begin, size_t end, size_t id)
+		{
+			size_t count = 0;
+			for (size_t i = begin; i < end; ++i)
+			{
+				keep[i] = static_cast<bool>(pred(first[i]));
+				count += keep[i];
+			}
+			offsets[id].value = count;
+		};
+
+		detail::run_schedule(sched, threads, errors, mark, finish);
+		errors.rethrow();
+
+		size_t total = 0;
+		for (auto& offset : offsets)
+			total += std::exchange(offset.value, total);
+
+		auto copy = [&](size_t begin, size_t end, size_t id)
+		{
+			auto out = std::ranges::next(d_first, offsets[id].value);
+			for (size_t i = begin; i < end; ++i)
+				if (keep[i])
+					*out++ = first[i];
+		};
+
+		detail::static_schedule copy_sched{size, threads};
+		detail::run_schedule(copy_sched, threads, errors, copy, finish);
+		errors.rethrow();
+
+		return std::ranges::next(d_first, total);
+	}
+
+	/**
+	 * \brief Parallel merge sort, not stable, like `std::sort`.
+	 *
+	 * `threads` runs are sorted in parallel with `std::sort`, then merged in 
+	 * rounds through a buffer of the same size. Every merge of a round is cut
+	 * along its merge path into pieces of equal length, so all threads stay busy
+	 * in the last rounds too. Ranges too small to give each thread a run of 
+	 * `sort_grain` elements are sorted serially. The value type must be default 
+	 * constructible and movable.
+	 *
+	 * \param first Iterator to start of range
+	 * \param last Iterator to end of range
+	 * \param comp Strict weak ordering
+	 * \param threads Number of threads to use
+	 */
+	template<std::random_access_iterator I, typename Comp = std::less<>>
+	inline void
+	async_sort(I first, I last, Comp comp = {}, size_t threads = runtime_threads())
+	{
+		using T = std::iter_value_t<I>;
+		size_t size = static_cast<size_t>(std::ranges::distance(first, last));
+		threads = std::min(threads, size / detail::sort_grain);
+		if (threads <= 1)
+		{
+			std::sort(first, last, comp);
+			return;
+		}
+
+		detail::error_state errors;
+		std::vector<size_t> bounds(threads + 1);
+		for (size_t i = 0; i <= threads; ++i)
+			bounds[i] = i * size / threads;
+
+		auto sort_run = [&](size_t id)
+		{
+			try
+			{
+				std::sort(std::ranges::next(first, bounds[id]), std::ranges::next(first, bounds[id + 1]), comp);
+			}
+			catch (...)
+			{
+				errors.capture();
+			}
+		};
+		detail::run_tasks(threads, sort_run, errors);
+		errors.rethrow();
+
+		std::vector<T> buffer(size);
+		bool in_buffer = false;
+
+		// Merge runs pairwise from `src` into `dst`; an odd last run is moved across.
+		auto merge_round = [&](auto src, auto dst)
+		{
+			size_t runs = bounds.size() - 1;
+			size_t pairs = runs / 2;
+			size_t parts = (threads + pairs - 1) / pairs;
+			size_t tasks = pairs * parts + runs % 2;
+
+			auto merge = [&](size_t t)
+			{
+				try
+				{
+					if (t == pairs * parts)
+					{
+						std::move(src + bounds[runs - 1], src + bounds[runs], dst + bounds[runs - 1]);
+						return;
+					}
+
+					size_t a = bounds[2 * (t / parts)];
+					size_t mid = bounds[2 * (t / parts) + 1];
+					size_t b = bounds[2 * (t / parts) + 2];
+					size_t m = mid - a, n = b - mid, part = t % parts;
+					size_t d0 = part * (m + n) / parts, d1 = (part + 1) * (m + n) / parts;
+					size_t i0 = detail::merge_split(src + a, m, src + mid, n, d0, comp);
+					size_t i1 = detail::merge_split(src + a, m, src + mid, n, d1, comp);
+
+					std::merge(std::make_move_iterator(src + a + i0), std::make_move_iterator(src + a + i1),
+						std::make_move_iterator(src + mid + (d0 - i0)), std::make_move_iterator(src + mid + (d1 - i1)),
+						dst + a + d0, comp);
+				}
+				catch (...)
+				{
+					errors.capture();
+				}
+			};
+			detail::run_tasks(tasks, merge, errors);
+			errors.rethrow();
+
+			std::vector<size_t> merged;
+			merged.reserve(pairs + 2);
+			for (size_t i = 0; i < bounds.size(); i += 2)
+				merged.push_back(bounds[i]);
+			if (runs % 2)
+				merged.push_back(bounds.back());
+			bounds = std::move(merged);
+		};
+
+		while (bounds.size() > 2)
+		{
+			if (in_buffer)
+				merge_round(buffer.begin(), first);
+			else
+				merge_round(first, buffer.begin());
+			in_buffer = !in_buffer;
+		}
+
+		if (in_buffer)
+			async_transform(buffer.begin(), buffer.end(), first, [](T& value) { return std::move(value); }, threads);
+	}
+
+	/**
+	 * \brief Parallel `std::find_if` with a selectable partitioning policy.
+	 *
+	 * Returns the first match, like `std::find_if`. Once a match is found, 
+	 * elements after it are no longer tested and the ranges after it are skipped,
+	 * so the search stops early instead of scanning the whole range. The 
+	 * partitioners that hand out ranges in order, `dynamic_partitioner` and
+	 * `guided_partitioner`, waste the least work past an early match.
+	 *
+	 * \tparam Pt Partitioner type
+	 * \param part Partitioning policy
+	 * \param first Iterator to start of range
+	 * \param last Iterator to end of range
+	 * \param pred Predicate
+	 * \param threads Number of threads to use
+	 * \return Iterator to the first element satisfying `pred`, or `last`
+	 */
+	template<partitioner Pt, std::random_access_iterator I, typename Pred>
+	inline I
+	async_find_if(Pt part, I first, I last, Pred pred, size_t threads = runtime_threads())
+	{
+		size_t size = static_cast<size_t>(std::ranges::distance(first, last));
+		if (size == 0) return last;
+		threads = detail::cap_threads(threads, size);
+
+		// Lowest matching index so far; no earlier match can be beaten by testing past it.
+		alignas(64) std::atomic<size_t> found{size};
+		detail::error_state errors;
+
+		auto body = [&](size_t begin, size_t end, size_t)
+		{
+			for (size_t i = begin; i < end && i < found.load(std::memory_order_relaxed); ++i)
+			{
+				if (pred(first[i]))
+				{
+					size_t current = found.load(std::memory_order_relaxed);
+					while (i < current && !found.compare_exchange_weak(current, i, std::memory_order_relaxed));
+					return;
+				}
+			}
+		};
+		detail::run_partitioned(part, size, threads, errors, body);
+		errors.rethrow();
+
+		return std::ranges::next(first, found.load());
+	}
+
+	/**
+	 * \brief Parallel `std::find_if`, static partitioning.
+	 * \see async_find_if
+	 */
+	template<std::random_access_iterator I, typename Pred>
+	inline I
+	async_find_if(I first, I last, Pred pred, size_t threads = runtime_threads())
+	{
+		return async_find_if(static_partitioner{}, first, last, std::move(pred), threads);
+	}
+
+	/**
+	 * \brief Parallel `std::any_of` with a selectable partitioning policy.
+	 *
+	 * The first match raises the loop's abort flag, the one an exception raises,
+	 * so every participant stops at its next element and unclaimed ranges are 
+	 * never started.
+	 */
+	template<partitioner Pt, std::random_access_iterator I, typename Pred>
+	inline bool
+	async_any_of(Pt part, I first, I last, Pred pred, size_t threads = runtime_threads())
+	{
+		size_t size = static_cast<size_t>(std::ranges::distance(first, last));
+		if (size == 0) return false;
+		threads = detail::cap_threads(threads, size);
+
+		alignas(64) std::atomic<bool> found{false};
+		detail::error_state errors;
+
+		auto body = [&](size_t begin, size_t end, size_t)
+		{
+			for (size_t i = begin; i < end && !errors.aborted(); ++i)
+			{
+				if (pred(first[i]))
+				{
+					found.store(true, std::memory_order_relaxed);
+					errors.stop();
+					return;
+				}
+			}
+		};
+		detail::run_partitioned(part, size, threads, errors, body);
+		errors.rethrow();
+
+		return found.load();
+	}
+
+	/**
+	 * \brief Parallel `std::any_of`, static partitioning.
+	 * \see async_any_of
+	 */
+	template<std::random_access_iterator I, typename Pred>
+	inline bool
+	async_any_of(I first, I last, Pred pred, size_t threads = runtime_threads())
+	{
+		return async_any_of(static_partitioner{}, first, last, std::move(pred), threads);
+	}
+
+	/**
+	 * \brief Per-thread storage indexed by the loop's thread id, after `tbb::enumerable_thread_specific`.
+	 *
+	 * Each slot sits on its own cache line and is constructed on first use by
+	 * `local(thread_id)`, from `init()` if one is given, so a loop body can reuse 
+	 * a scratch object per participant without locks or per-element allocation.
+	 * The slots persist across loops until `clear()`, and `combine()` folds them 
+	 * once at the end. A slot must only be used by one participant at a time, 
+	 * i.e. by one loop at a time.
+	 *
+	 * \tparam T Slot type
+	 */
+	template<typename T>
+	class enumerable_thread_specific
+	{
+	public:
+		/**
+		 * \param slots Number of thread ids served, at least the `threads` of the loops using it
+		 */
+		explicit enumerable_thread_specific(size_t slots = runtime_threads())
+			: _slots(slots)
+		{
+		}
+
+		/**
+		 * \param init Callable returning the initial value of each slot
+		 * \param slots Number of thread ids served
+		 */
+		template<typename Init>
+			requires std::convertible_to<std::invoke_result_t<Init&>, T>
+		explicit enumerable_thread_specific(Init init, size_t slots = runtime_threads())
+			: _init(std::move(init)), _slots(slots)
+		{
+		}
+
+		/// Number of thread ids served.
+		size_t slots() const noexcept { return _slots.size(); }
+
+		/// Number of slots constructed so far.
+		size_t size() const noexcept
+		{
+			return std::ranges::count_if(_slots, [](const auto& slot) { return slot.value.has_value(); });
+		}
+
+		/**
+		 * \brief Slot of `thread_id`, constructed on first use.
+		 */
+		T& local(size_t thread_id)
+		{
+			std::optional<T>& slot = _slots.at(thread_id).value;
+			if (!slot)
+			{
+				if (_init) slot.emplace(_init());
+				else slot.emplace();
+			}
+			return *slot;
+		}
+
+		/**
+		 * \brief Call `f(value)` on every constructed slot, in thread id order.
+		 */
+		template<typename F>
+		void combine_each(F&& f)
+		{
+			for (auto& slot : _slots)
+				if (slot.value)
+					f(*slot.value);
+		}
+
+		/**
+		 * \brief Fold the constructed slots with `op`, in thread id order.
+		 * \return The folded value, or a value-initialised `T` if no slot was used
+		 */
+		template<typename Op>
+		T combine(Op op) const
+		{
+			std::optional<T> acc;
+			for (const auto& slot : _slots)
+				if (slot.value)
+					acc = acc ? op(std::move(*acc), *slot.value) : *slot.value;
+			return acc ? std::move(*acc) : T{};
+		}
+
+		/// Destroy every slot.
+		void clear() noexcept
+		{
+			for (auto& slot : _slots)
+				slot.value.reset();
+		}
+
+	private:
+		std::function<T()> _init;
+		std::vector<detail::padded<std::optional<T>>> _slots;
+	};
+
+	/**
+	 * \brief Bump allocator for per-thread scratch memory, reset between uses.
+	 *
+	 * `allocate` carves suitably aligned storage out of one block; when the block
+	 * runs out, overflow blocks take the excess until `reset()`, which then grows
+	 * the block to the high-water mark. After warm-up, a thread's scratch memory
+	 * therefore costs a pointer bump and no heap traffic. Intended for trivially 
+	 * destructible types, as nothing is destroyed on reset. Pair with 
+	 * `enumerable_thread_specific<scratch_arena>` for one arena per participant.
+	 */
+	class scratch_arena
+	{
+	public:
+		explicit scratch_arena(size_t capacity = 64 * 1024)
+			: _capacity(std::max<size_t>(capacity, 64)), _block(std::make_unique<std::byte[]>(_capacity))
+		{
+		}
+
+		scratch_arena(scratch_arena&&) noexcept = default;
+		scratch_arena& operator=(scratch_arena&&) noexcept = default;
+
+		/**
+		 * \brief Default-initialised storage for `n` objects of type `U`, valid until `reset()`.
+		 */
+		template<typename U>
+		std::span<U> allocate(size_t n)
+		{
+			static_assert(std::is_trivially_destructible_v<U>, "scratch_arena does not run destructors");
+			void* p = bump(n * sizeof(U), alignof(U));
+			U* first = static_cast<U*>(p);
+			std::uninitialized_default_construct_n(first, n);
+			return {first, n};
+		}
+
+		/// Release every allocation, keeping (and if it overflowed, growing) the block.
+		void reset()
+		{
+			if (!_overflow.empty())
+			{
+				_capacity = std::bit_ceil(_high_water);
+				_block = std::make_unique<std::byte[]>(_capacity);
+				_overflow.clear();
+			}
+			_used = 0;
+			_high_water = 0;
+		}
+
+		/// Bytes handed out since the last `reset()`, including alignment padding.
+		size_t used() const noexcept { return _high_water; }
+
+		/// Size of the main block.
+		size_t capacity() const noexcept { return _capacity; }
+
+	private:
+		void* bump(size_t bytes, size_t align)
+		{
+			void* p = _block.get() + _used;
+			size_t space = _capacity - _used;
+			if (std::align(align, bytes, p, space))
+			{
+				size_t consumed = (_capacity - _used) - space + bytes;
+				_used += consumed;
+				_high_water += consumed;
+				return p;
+			}
+
+			// Overflow: a dedicated block, freed at the next reset.
+			_overflow.push_back(std::make_unique<std::byte[]>(bytes + align));
+			p = _overflow.back().get();
+			space = bytes + align;
+			std::align(align, bytes, p, space);
+			_high_water += bytes + align;
+			return p;
+		}
+
+		size_t _capacity;
+		std::unique_ptr<std::byte[]> _block;
+		std::vector<std::unique_ptr<std::byte[]>> _overflow;
+		size_t _used = 0;
+		size_t _high_water = 0;
+	};
+
+	namespace detail
+	{
+		/// A loop whose participants produce a value, read once it has completed.
+		template<typename T>
+		struct result_state : loop_state
+		{
+			virtual T result() = 0;
+		};
+
+		/// A partitioned transform-reduce run by a `loop_state`.
+		template<typename S, typename I, typename T, typename Op, typename U>
+		struct launched_reduce : result_state<T>
+		{
+			S sched;
+			I begin;
+			T init;
+			Op op;
+			U transform;
+			std::vector<padded<std::optional<T>>> partials;
+
+			template<typename Pt>
+			launched_reduce(Pt part, I begin, size_t size, size_t threads, T init, Op op, U transform)
+				: sched(make_schedule(part, size, threads, this->errors)), begin(begin), 
+				init(std::move(init)), op(std::move(op)), transform(std::move(transform)), partials(threads)
+			{
+			}
+
+			void run(size_t id) override
+			{
+				index_range r{0, 0};
+				while (!this->errors.aborted() && sched.next(id, r))
+				{
+					reduce_range(begin, r.first, r.last, partials[id].value, op, transform);
+					sched.done(r);
+					yield_to_urgent();
+				}
+			}
+
+			T result() override { return combine(std::move(init), partials, op); }
+		};
+	}
+
+	/**
+	 * \brief Handle to a parallel reduction running in the background.
+	 *
+	 * A `loop_handle` whose `get()`, or `co_await`, also yields the reduced value.
+	 * The value can be retrieved once.
+	 */
+	template<typename T>
+	class result_handle
+	{
+	public:
+		result_handle() = default;
+
+		explicit result_handle(std::shared_ptr<detail::result_state<T>> state) noexcept
+			: _loop(state), _state(std::move(state))
+		{
+		}
+
+		/// True if the handle refers to a reduction.
+		bool valid() const noexcept { return _loop.valid(); }
+
+		/// True once the reduction has completed.
+		bool is_ready() const { return _loop.is_ready(); }
+
+		/// \see loop_handle::wait_for
+		template<typename Rep, typename Period>
+		bool wait_for(const std::chrono::duration<Rep, Period>& timeout) const { return _loop.wait_for(timeout); }
+
+		/// Wait for the reduction, rethrowing its first exception.
+		void wait() { _loop.wait(); }
+
+		/// Wait for the reduction and return its value.
+		T get()
+		{
+			_loop.wait();
+			return _state->result();
+		}
+
+		/// Suspend the awaiting coroutine until the reduction completes, then yield its value.
+		auto operator co_await() noexcept
+		{
+			struct awaiter
+			{
+				detail::result_state<T>* state;
+
+				bool await_ready() const noexcept { return false; }
+				bool await_suspend(std::coroutine_handle<> h) { return state->suspend(h); }
+				T await_resume() const 
+				{ 
+					state->errors.rethrow(); 
+					return state->result(); 
+				}
+			};
+			return awaiter{_state.get()};
+		}
+
+	private:
+		loop_handle _loop;
+		std::shared_ptr<detail::result_state<T>> _state;
+	};
+
+	/**
+	 * \brief Start a partitioned parallel transform-reduce and return without waiting for it.
+	 * \see async_transform_reduce
+	 * \see async_launch_for_each
+	 */
+	template<partitioner Pt, std::random_access_iterator I, typename T, typename Op, typename U>
+	inline result_handle<T>
+	async_launch_transform_reduce(Pt part, I begin, I end, T init, Op op, U transform, size_t threads = runtime_threads())
+	{
+		size_t size = static_cast<size_t>(std::ranges::distance(begin, end));
+		threads = detail::cap_threads(threads, size);
+
+		using schedule = decltype(detail::make_schedule(part, size, threads, std::declval<detail::error_state&>()));
+		auto loop = std::make_shared<detail::launched_reduce<schedule, I, T, Op, U>>(
+			part, begin, size, threads, std::move(init), std::move(op), std::move(transform));
+
+		if (size == 0)
+			loop->done = true;
+		else if constexpr (requires { loop->sched.place(size_t{}); })
+			detail::launch(loop, threads, [loop](size_t id) { return loop->sched.place(id); });
+		else
+			detail::launch(loop, threads, [](size_t) { return detail::no_worker; });
+
+		return result_handle<T>(std::move(loop));
+	}
+
+	/**
+	 * \brief Start a parallel reduction and return without waiting for it.
+	 * \see async_reduce
+	 * \see async_launch_for_each
+	 */
+	template<std::random_access_iterator I, typename T, typename Op = std::plus<>>
+	inline result_handle<T>
+	async_launch_reduce(I begin, I end, T init, Op op = {}, size_t threads = runtime_threads())
+	{
+		return async_launch_transform_reduce(static_partitioner{}, begin, end, std::move(init), 
+			std::move(op), std::identity{}, threads);
+	}
+
+	template<typename T = void>
+	class task;
+
+	namespace detail
+	{
+		/// Final awaiter of a `task<T>`: transfer to the awaiting coroutine, or signal `sync_wait`.
+		struct task_final_awaiter
+		{
+			bool await_ready() const noexcept { return false; }
+
+			template<typename P>
+			std::coroutine_handle<> await_suspend(std::coroutine_handle<P> h) const noexcept
+			{
+				auto& promise = h.promise();
+				if (promise.continuation)
+					return promise.continuation;
+				// Last use of the frame: `sync_wait` may destroy it once the count drops,
+				// and `arrive` touches only the pool after that.
+				if (auto* pending = promise.pending)
+					thread_pool::instance().arrive(*pending);
+				return std::noop_coroutine();
+			}
+
+			void await_resume() const noexcept {}
+		};
+
+		/// Promise state common to every `task<T>`.
+		struct task_promise_base
+		{
+			std::coroutine_handle<> continuation;   ///< Coroutine awaiting this task, if any
+			std::exception_ptr ex_ptr = nullptr;
+			std::atomic<size_t>* pending = nullptr; ///< Countdown of the `sync_wait` running the task, if any
+
+			std::suspend_always initial_suspend() const noexcept { return {}; }
+
+			task_final_awaiter final_suspend() const noexcept { return {}; }
+
+			void unhandled_exception() noexcept { ex_ptr = std::current_exception(); }
+
+			void rethrow() const
+			{
+				if (ex_ptr) 
+					std::rethrow_exception(ex_ptr);
+			}
+		};
+
+		template<typename T>
+		struct task_promise : task_promise_base
+		{
+			std::optional<T> value;
+
+			task<T> get_return_object() noexcept;
+
+			template<typename V>
+			void return_value(V&& v) { value.emplace(std::forward<V>(v)); }
+
+			T result()
+			{
+				rethrow();
+				return std::move(*value);
+			}
+		};
+
+		template<>
+		struct task_promise<void> : task_promise_base
+		{
+			task<void> get_return_object() noexcept;
+
+			void return_void() const noexcept {}
+
+			void result() const { rethrow(); }
+		};
+	}
+
+	/**
+	 * \brief Lazily started coroutine producing a `T`.
+	 *
+	 * A task starts when awaited, and resumes its awaiter when it completes.
+	 * Awaiting a launched loop or reduction inside a task suspends it without 
+	 * blocking a thread; it then continues on the pool worker that finished the 
+	 * loop. Use `sync_wait` to run a task from ordinary code.
+	 */
+	template<typename T>
+	class task
+	{
+	public:
+		using promise_type = detail::task_promise<T>;
+
+		explicit task(std::coroutine_handle<promise_type> handle) noexcept : _handle(handle) {}
+
+		task(task&& other) noexcept : _handle(std::exchange(other._handle, {})) {}
+
+		task& operator=(task&& other) noexcept
+		{
+			if (this != &other)
+			{
+				if (_handle) _handle.destroy();
+				_handle = std::exchange(other._handle, {});
+			}
+			return *this;
+		}
+
+		~task() 
+		{ 
+			if (_handle) _handle.destroy(); 
+		}
+
+		/// Start the task and suspend the awaiting coroutine until it completes.
+		auto operator co_await() noexcept
+		{
+			struct awaiter
+			{
+				std::coroutine_handle<promise_type> handle;
+
+				bool await_ready() const noexcept { return false; }
+
+				std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+				{
+					handle.promise().continuation = awaiting;
+					return handle;
+				}
+
+				T await_resume() { return handle.promise().result(); }
+			};
+			return awaiter{_handle};
+		}
+
+		/**
+		 * \brief Run the task to completion from a non-coroutine, running queued pool tasks meanwhile.
+		 */
+		T sync_wait()
+		{
+			// Owned here rather than by the frame, so completion never signals through the frame.
+			std::atomic<size_t> pending{1};
+			auto& promise = _handle.promise();
+			promise.pending = &pending;
+			_handle.resume();
+
+			thread_pool::instance().join(pending);
+			return promise.result();
+		}
+
+	private:
+		std::coroutine_handle<promise_type> _handle;
+	};
+
+	template<typename T>
+	inline task<T> 
+	detail::task_promise<T>::get_return_object() noexcept
+	{
+		return task<T>(std::coroutine_handle<task_promise<T>>::from_promise(*this));
+	}
+
+	inline task<void> 
+	detail::task_promise<void>::get_return_object() noexcept
+	{
+		return task<void>(std::coroutine_handle<task_promise<void>>::from_promise(*this));
+	}
+
+	/**
+	 * \brief Run `t` to completion from ordinary code and return its result.
+	 */
+	template<typename T>
+	inline T
+	sync_wait(task<T> t)
+	{
+		return t.sync_wait();
+	}
+
+	/**
+	 * \brief Reusable dependency graph of tasks and parallel loops.
+	 *
+	 * Nodes are added with `emplace` (a single task) or `emplace_for_each` (a
+	 * parallel loop) and ordered with `precede`. `run()` executes the graph on 
+	 * the pool, starting each node as soon as its last predecessor finishes, so 
+	 * independent stages overlap instead of joining one after another. Once any 
+	 * node throws, nodes that have not started are skipped and `run()` rethrows
+	 * the first exception. A graph may be run any number of times, but not 
+	 * concurrently with itself or while it is being modified.
+	 */
+	class task_graph
+	{
+	public:
+		/// Node identifier, in order of creation.
+		using node = size_t;
+
+		/**
+		 * \brief Add a node running `f()` as a single task.
+		 */
+		template<typename F>
+		node emplace(F f)
+		{
+			_nodes.emplace_back(std::move(f));
+			_validated = false;
+			return _nodes.size() - 1;
+		}
+
+		/**
+		 * \brief Add a node running `async_for_each(part, begin, end, f, threads)`.
+		 */
+		template<partitioner Pt, typename I, typename F>
+		node emplace_for_each(Pt part, I begin, I end, F f, size_t threads = runtime_threads())
+		{
+			return emplace([=]() mutable { async_for_each(part, begin, end, f, threads); });
+		}
+
+		/**
+		 * \brief Add a node running `async_for_each(begin, end, f, threads)`.
+		 */
+		template<typename I, typename F>
+		node emplace_for_each(I begin, I end, F f, size_t threads = runtime_threads())
+		{
+			return emplace([=]() mutable { async_for_each(begin, end, f, threads); });
+		}
+
+		/**
+		 * \brief Make `before` a predecessor of `after`.
+		 */
+		void precede(node before, node after)
+		{
+			_nodes[before].successors.push_back(after);
+			_nodes[after].predecessors++;
+			_validated = false;
+		}
+
+		/// Number of nodes.
+		size_t size() const noexcept { return _nodes.size(); }
+
+		/**
+		 * \brief Execute the graph and wait for it, running queued pool tasks meanwhile.
+		 * \throws std::logic_error if the dependencies contain a cycle
+		 */
+		void run()
+		{
+			if (_nodes.empty()) return;
+			validate();
+
+			detail::error_state errors;
+			std::atomic<size_t> pending{_nodes.size()};
+			std::mutex done_mutex;
+			std::condition_variable done_cv;
+			bool done = false;
+			thread_pool& pool = thread_pool::instance();
+
+			for (auto& n : _nodes)
+				n.remaining.store(n.predecessors, std::memory_order_relaxed);
+
+			// Runs node `id`, then releases its successors; the last node signals completion.
+			std::function<void(node)> execute = [&](node id)
+			{
+				auto& n = _nodes[id];
+				if (!errors.aborted())
+				{
+					try
+					{
+						n.work();
+					}
+					catch (...)
+					{
+						errors.capture();
+					}
+				}
+
+				for (node next : n.successors)
+					if (_nodes[next].remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+						pool.submit([&execute, next] { execute(next); });
+
+				if (pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+				{
+					// Notify under the lock: `run()` may return as soon as it is released.
+					std::lock_guard<std::mutex> lock(done_mutex);
+					done = true;
+					done_cv.notify_all();
+				}
+			};
+
+			for (node id = 0; id < _nodes.size(); ++id)
+				if (_nodes[id].predecessors == 0)
+					pool.submit([&execute, id] { execute(id); });
+
+			for (;;)
+			{
+				{
+					std::lock_guard<std::mutex> lock(done_mutex);
+					if (done) break;
+				}
+				if (!pool.try_run_one())
+				{
+					std::unique_lock<std::mutex> lock(done_mutex);
+					done_cv.wait(lock, [&] { return done; });
+				}
+			}
+
+			errors.rethrow();
+		}
+
+	private:
+		struct node_data
+		{
+			std::move_only_function<void()> work;
+			std::vector<node> successors;
+			size_t predecessors = 0;
+			std::atomic<size_t> remaining{0};
+
+			template<typename F>
+			explicit node_data(F&& f) : work(std::forward<F>(f)) {}
+		};
+
+		/// Check that every node is reachable in topological order (Kahn's algorithm).
+		void validate()
+		{
+			if (_validated) return;
+
+			std::vector<size_t> in_degree(_nodes.size());
+			std::vector<node> ready;
+			for (node id = 0; id < _nodes.size(); ++id)
+				if ((in_degree[id] = _nodes[id].predecessors) == 0)
+					ready.push_back(id);
+
+			size_t visited = 0;
+			while (!ready.empty())
+			{
+				node id = ready.back();
+				ready.pop_back();
+				++visited;
+				for (node next : _nodes[id].successors)
+					if (--in_degree[next] == 0)
+						ready.push_back(next);
+			}
+
+			if (visited != _nodes.size())
+				throw std::logic_error("task_graph contains a dependency cycle");
+			_validated = true;
+		}
+
+		std::deque<node_data> _nodes;
+		bool _validated = false;
+	};
+
+	/**
+	 * \brief Bounded lock-free multi-producer multi-consumer ring buffer.
+	 *
+	 * Dmitry Vyukov's bounded MPMC queue: each cell carries a sequence number 
+	 * telling producers and consumers whether it is free or full for their lap,
+	 * so `try_push` and `try_pop` cost one CAS on the shared cursor when
+	 * uncontended. Suits single-producer / single-consumer use as well.
+	 * The capacity is rounded up to a power of two.
+	 */
+	template<typename T>
+	class bounded_queue
+	{
+	public:
+		explicit bounded_queue(size_t capacity)
+			: _mask(std::bit_ceil(std::max<size_t>(2, capacity)) - 1),
+			_cells(std::make_unique<cell[]>(_mask + 1))
+		{
+			for (size_t i = 0; i <= _mask; ++i)
+				_cells[i].sequence.store(i, std::memory_order_relaxed);
+		}
+
+		bounded_queue(const bounded_queue&) = delete;
+		bounded_queue& operator=(const bounded_queue&) = delete;
+
+		/// Number of elements the queue can hold.
+		size_t capacity() const noexcept { return _mask + 1; }
 
-	/** 
-	 * \brief runtime support for setting threads with environment variable
-	 * \note this only applies .
-	 * \note  
-	 */
-	inline size_t runtime_threads() 
-	{
-		static size_t _threads = 0;
-		if ( _threads == 0) 
+		/**
+		 * \brief Append `value` unless the queue is full.
+		 * \return false if the queue was full
+		 */
+		bool try_push(T value)
 		{
-			const char* env_async = std::getenv("ASYNC_NUM_THREADS");    
-			if (env_async) 
+			cell* c;
+			size_t pos = _enqueue.load(std::memory_order_relaxed);
+			for (;;)
 			{
+				c = &_cells[pos & _mask];
+				size_t seq = c->sequence.load(std::memory_order_acquire);
+				auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+				if (diff == 0)
+				{
+					if (_enqueue.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+						break;
+				}
+				else if (diff < 0)
+					return false;
+				else
+					pos = _enqueue.load(std::memory_order_relaxed);
+			}
+			c->value = std::move(value);
+			c->sequence.store(pos + 1, std::memory_order_release);
+			return true;
+		}
 
-				_threads = 
-					std::min(ASYNC_MAX_THREADS, 
-						std::max(ASYNC_MIN_THREADS, std::atoi(env_async)));
-			} 
-			else 
+		/**
+		 * \brief Remove the oldest element into `value` unless the queue is empty.
+		 * \return false if the queue was empty
+		 */
+		bool try_pop(T& value)
+		{
+			cell* c;
+			size_t pos = _dequeue.load(std::memory_order_relaxed);
+			for (;;)
 			{
-				_threads = threads;
+				c = &_cells[pos & _mask];
+				size_t seq = c->sequence.load(std::memory_order_acquire);
+				auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos + 1);
+				if (diff == 0)
+				{
+					if (_dequeue.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+						break;
+				}
+				else if (diff < 0)
+					return false;
+				else
+					pos = _dequeue.load(std::memory_order_relaxed);
 			}
+			value = std::move(c->value);
+			c->sequence.store(pos + _mask + 1, std::memory_order_release);
+			return true;
 		}
-		return _threads;
-	}
+
+	private:
+		struct alignas(64) cell
+		{
+			std::atomic<size_t> sequence;
+			T value;
+		};
+
+		const size_t _mask;
+		std::unique_ptr<cell[]> _cells;
+		alignas(64) std::atomic<size_t> _enqueue{0};
+		alignas(64) std::atomic<size_t> _dequeue{0};
+	};
 
 	/**
-	 * \brief Launch an asynchronous task using std::async with forwarded parameters.
-	 * \tparam F Callable type
-	 * \tparam Ts Argument types
-	 * \param f Callable to execute
-	 * \param params Arguments to pass to callable
-	 * \return std::future holding the result of the async operation
+	 * \brief Execution mode of a pipeline stage, after `tbb::filter_mode`.
 	 */
-	template<typename F, typename... Ts> 
-	inline std::future<typename std::result_of<F(Ts...)>::type>
-	call_async(F&& f, Ts&&... params) 
+	enum class stage_mode
 	{
-		return std::async(std::launch::async, 
-			std::forward<F>(f), 
-			std::forward<Ts>(params)...);
-	}
-
-	/// Trait for checking if an iterator is random access
-	template<typename I>
-	constexpr bool is_random_access_iterator_v = std::random_access_iterator<I>;
+		serial_in_order,     ///< One item at a time, in the order the source produced them
+		serial_out_of_order, ///< One item at a time, in any order
+		parallel             ///< Any number of items at once
+	};
 
 	/**
-	 * \brief Launches a parallel for-each operation across a range using asynchronous tasks.
-	 * 
-	 * Optimized with atomic operations for better performance.
-	 * 
-	 * \tparam I Iterator type
-	 * \tparam F Callable type
-	 * \tparam P Progress callback type
-	 * \param begin Iterator to start of range
-	 * \param end Iterator to end of range
-	 * \param f Function to invoke on each element (can optionally take an index)
-	 * \param threads Number of threads to use
-	 * \param progress Optional progress callback (receives count of completed threads)
+	 * \brief Streaming pipeline over items of type `T`, after `tbb::parallel_pipeline`.
+	 *
+	 * A serial source fills items, which then pass through the stages in order,
+	 * each stage updating the item in place. At most `tokens` items are in flight;
+	 * their storage is allocated once per pipeline and recycled, which caps memory
+	 * regardless of the stream length. Stages are connected by `bounded_queue`s,
+	 * and a `serial_in_order` stage reads from a reorder ring indexed by the item's
+	 * sequence number. `run()` executes the pipeline on pool workers, any of which
+	 * may run any stage, favouring stages nearer the end so items drain.
+	 *
+	 * \tparam T Item type, default constructible and reused between items
 	 */
-	template<typename I, typename F, typename P>
-	inline void 
-	async_for_each(I begin, I end, F&& f,
-						size_t threads = runtime_threads(),
-						P&& progress = [](size_t) {})
+	template<typename T>
+	class pipeline
 	{
-		using difference_type = typename std::iterator_traits<I>::difference_type;
-		auto size = std::ranges::distance(begin, end);
-		if (size == 0) return;
+	public:
+		/**
+		 * \param tokens Maximum number of items in flight
+		 */
+		explicit pipeline(size_t tokens = 2 * runtime_threads())
+			: _tokens(std::max<size_t>(1, tokens))
+		{
+		}
 
-		threads = std::min(threads, static_cast<size_t>(size));
-		auto chunk_size = size / threads;
-		std::vector<std::future<void>> futures(threads);
+		/**
+		 * \brief Set the source, `bool f(T& item)`: fill `item`, or return false at the end of the stream.
+		 *
+		 * The source runs serially, one item at a time.
+		 */
+		template<typename F>
+		pipeline& source(F f)
+		{
+			_source = std::move(f);
+			return *this;
+		}
 
-		alignas(64) std::atomic<bool> abort{false};
-		alignas(64) std::atomic<size_t> completed{0};
+		/**
+		 * \brief Append a stage `void f(T& item)` run in `mode`.
+		 */
+		template<typename F>
+		pipeline& stage(stage_mode mode, F f)
+		{
+			_stages.push_back({mode, std::move(f)});
+			return *this;
+		}
+
+		/**
+		 * \brief Run the pipeline until the source is exhausted and every item has left the last stage.
+		 *
+		 * Rethrows the first exception raised by the source or a stage; items not 
+		 * yet started are then dropped.
+		 * \param threads Number of threads to use
+		 */
+		void run(size_t threads = runtime_threads())
+		{
+			if (!_source) return;
 
-		std::exception_ptr ex_ptr = nullptr;
-		std::mutex ex_mutex;
+			run_state state(_tokens, _stages);
+			detail::error_state errors;
 
-		I chunk_begin = begin;
+			auto task = [&](size_t)
+			{
+				try
+				{
+					size_t idle = 0;
+					while (!errors.aborted())
+					{
+						if (step(state))
+						{
+							idle = 0;
+							continue;
+						}
+						if (state.exhausted.load(std::memory_order_acquire) 
+							&& state.in_flight.load(std::memory_order_acquire) == 0)
+							break;
+						if (++idle > 64)
+							std::this_thread::yield();
+					}
+				}
+				catch (...)
+				{
+					errors.capture();
+				}
+			};
+
+			detail::run_tasks(std::max<size_t>(1, threads), task, errors);
+			errors.rethrow();
+		}
+
+	private:
+		struct stage_def
+		{
+			stage_mode mode;
+			std::function<void(T&)> f;
+		};
 
-		for (size_t i = 0; i < threads; ++i)
+		/// Per-stage state of one run.
+		struct alignas(64) stage_state
 		{
-			I chunk_end;
+			const stage_def& def;
+			bounded_queue<size_t> input;                   ///< Slots ready for this stage, unordered
+			std::vector<std::atomic<size_t>> reorder;      ///< slot + 1 at `seq % tokens`, for in-order stages
+			alignas(64) std::atomic<bool> busy{false};     ///< Held while a serial stage runs
+			size_t next = 0;                               ///< Next sequence number of an in-order stage
 
-			if constexpr (is_random_access_iterator_v<I>)
+			stage_state(const stage_def& def, size_t tokens)
+				: def(def), input(tokens), 
+				reorder(def.mode == stage_mode::serial_in_order ? tokens : 0)
 			{
-				chunk_end = (i == threads - 1) ? end : std::ranges::next(chunk_begin, chunk_size);
 			}
-			else
+		};
+
+		/// State of one run: item slots, the free list and the stage connections.
+		struct run_state
+		{
+			std::vector<T> items;
+			std::vector<size_t> seq;
+			bounded_queue<size_t> free;
+			std::deque<stage_state> stages;
+			alignas(64) std::atomic<bool> source_busy{false};
+			alignas(64) std::atomic<bool> exhausted{false};
+			alignas(64) std::atomic<size_t> in_flight{0};
+			size_t next_seq = 0;
+
+			run_state(size_t tokens, const std::vector<stage_def>& defs)
+				: items(tokens), seq(tokens), free(tokens)
 			{
-				chunk_end = chunk_begin;
-				difference_type steps = (i == threads - 1) ? size : chunk_size;
-				while (steps-- && chunk_end != end) ++chunk_end;
+				for (size_t slot = 0; slot < tokens; ++slot)
+					free.try_push(slot);
+				for (const auto& def : defs)
+					stages.emplace_back(def, tokens);
 			}
+		};
 
-			auto local_chunk_begin = chunk_begin;
-			auto local_chunk_end = chunk_end;
-			auto chunk_len = std::ranges::distance(local_chunk_begin, local_chunk_end);
-			auto idx_offset = i * chunk_len;
+		/// Perform one unit of work, preferring later stages. \return false if none was available
+		bool step(run_state& state)
+		{
+			for (size_t k = state.stages.size(); k-- > 0;)
+				if (try_stage(state, k))
+					return true;
+			return try_source(state);
+		}
 
-			futures[i] = call_async([=, &f, &abort, &ex_ptr, &ex_mutex, &completed, &progress]() mutable 
+		/// Hand `slot` to stage `k`, or recycle it past the last stage.
+		void forward(run_state& state, size_t k, size_t slot)
+		{
+			if (k == state.stages.size())
 			{
-				#ifdef __linux__
-					cpu_set_t cpuset;
-					CPU_ZERO(&cpuset);
-					CPU_SET(i % std::thread::hardware_concurrency(), &cpuset);
-					pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset);					
-				#endif
+				state.free.try_push(slot);
+				state.in_flight.fetch_sub(1, std::memory_order_acq_rel);
+			}
+			else if (state.stages[k].def.mode == stage_mode::serial_in_order)
+				state.stages[k].reorder[state.seq[slot] % _tokens].store(slot + 1, std::memory_order_release);
+			else
+				state.stages[k].input.try_push(slot); // never full: at most `tokens` slots exist
+		}
+
+		bool try_source(run_state& state)
+		{
+			if (state.exhausted.load(std::memory_order_acquire) 
+				|| state.source_busy.exchange(true, std::memory_order_acquire))
+				return false;
 
+			size_t slot;
+			bool produced = false;
+			if (!state.exhausted.load(std::memory_order_relaxed) && state.free.try_pop(slot))
+			{
+				bool more;
 				try
 				{
-					size_t idx = idx_offset;
-					for (auto it = local_chunk_begin; it != local_chunk_end; ++it)
-					{
-						[[assume(!abort.load(std::memory_order_relaxed))]];
-						if (abort.load(std::memory_order_relaxed)) break;
-
-						if constexpr (std::is_invocable_v<F, decltype(*it), size_t, size_t>)
-							f(*it, idx++, i); // i is the thread id
-						else if constexpr (std::is_invocable_v<F, decltype(*it), size_t>)
-							f(*it, idx++);
-						else if constexpr (std::is_invocable_v<F, decltype(*it)>)
-							f(*it);
-						else
-							static_assert(false, "f must be invocable with (T), (T, size_t) or (T, size_t, size_t)");
-					}
-					
-					auto prev_completed = completed.fetch_add(1, std::memory_order_relaxed);
-					progress(prev_completed + 1);
+					more = _source(state.items[slot]);
 				}
 				catch (...)
 				{
-					[[assume(!abort.load(std::memory_order_relaxed))]];
-					if (!abort.load(std::memory_order_relaxed))
-					{
-						std::lock_guard<std::mutex> lock(ex_mutex);
-						if (!ex_ptr)
-						{
-							ex_ptr = std::current_exception();
-							abort.store(true, std::memory_order_relaxed);
-						}
-					}
+					state.free.try_push(slot);
+					state.source_busy.store(false, std::memory_order_release);
+					throw;
 				}
-			});
 
-			chunk_begin = chunk_end;
+				if (more)
+				{
+					state.seq[slot] = state.next_seq++;
+					state.in_flight.fetch_add(1, std::memory_order_acq_rel);
+					produced = true;
+				}
+				else
+				{
+					state.free.try_push(slot);
+					state.exhausted.store(true, std::memory_order_release);
+				}
+			}
+			state.source_busy.store(false, std::memory_order_release);
+
+			if (produced)
+				forward(state, 0, slot);
+			return produced;
 		}
 
-		for (auto& fut : futures)
+		bool try_stage(run_state& state, size_t k)
 		{
-			try 
-			{ 
-				fut.get(); 
-			}
-			catch (...)
+			auto& st = state.stages[k];
+			size_t slot = 0;
+
+			switch (st.def.mode)
 			{
-				[[assume(!abort.load(std::memory_order_relaxed))]];
-				if (!abort.load(std::memory_order_relaxed))
+				case stage_mode::parallel:
+					if (!st.input.try_pop(slot)) return false;
+					st.def.f(state.items[slot]);
+					break;
+
+				case stage_mode::serial_out_of_order:
+					if (st.busy.exchange(true, std::memory_order_acquire)) return false;
+					if (!st.input.try_pop(slot))
+					{
+						st.busy.store(false, std::memory_order_release);
+						return false;
+					}
+					run_serial(st, state.items[slot]);
+					break;
+
+				case stage_mode::serial_in_order:
 				{
-					std::lock_guard<std::mutex> lock(ex_mutex);
-					if (!ex_ptr)
+					if (st.busy.exchange(true, std::memory_order_acquire)) return false;
+					auto& cell = st.reorder[st.next % _tokens];
+					size_t ready = cell.load(std::memory_order_acquire);
+					if (ready == 0)
 					{
-						ex_ptr = std::current_exception();
-						abort.store(true, std::memory_order_relaxed);
+						st.busy.store(false, std::memory_order_release);
+						return false;
 					}
+					cell.store(0, std::memory_order_relaxed);
+					slot = ready - 1;
+					st.next++;
+					run_serial(st, state.items[slot]);
+					break;
 				}
 			}
+
+			forward(state, k + 1, slot);
+			return true;
 		}
 
-		std::lock_guard<std::mutex> final_lock(ex_mutex);
-		if (ex_ptr) 
-			std::rethrow_exception(ex_ptr);
-	}
+		/// Run a serial stage on `item` and release it, also on exception.
+		static void run_serial(stage_state& st, T& item)
+		{
+			try
+			{
+				st.def.f(item);
+			}
+			catch (...)
+			{
+				st.busy.store(false, std::memory_order_release);
+				throw;
+			}
+			st.busy.store(false, std::memory_order_release);
+		}
 
-	/**
-	 * \brief Overload of async_for_each without progress callback.
-	 */
-	template<typename I, typename F>
-	inline void async_for_each(I begin, I end, F&& f, size_t threads = runtime_threads()) 
-	{
-		async_for_each(begin, end, std::forward<F>(f), threads, [](size_t) {});
-	}
+		size_t _tokens;
+		std::function<bool(T&)> _source;
+		std::vector<stage_def> _stages;
+	};
 
 	/**
 	 * \brief Create stepped integer sequence at compile-time
@@ -270,7 +5479,7 @@ namespace async
 	{
 		static constexpr size_t total = (Nn - N0 + Ns - 1) / Ns;
 		static constexpr T chunk_size = (total + Cn - 1) / Cn;
-		static constexpr T offset = Ci * chunk_size;
+		static constexpr T offset = (Ci * chunk_size < total) ? Ci * chunk_size : total;
 		static constexpr T count = (offset + chunk_size > total) ? (total - offset) : chunk_size;
 		static constexpr T chunk_start = N0 + offset * Ns;
 		static constexpr T chunk_end   = chunk_start + count * Ns;
@@ -307,69 +5516,25 @@ namespace async
 	{
 		static constexpr size_t chunk_count = sizeof...(Is);
 		
-		alignas(64) std::atomic<bool> abort{false};
+		detail::error_state errors;
 
-		std::exception_ptr ex_ptr = nullptr;
-		std::mutex ex_mutex;
-
-		auto futures = std::make_tuple(
-			call_async([=, &f, &abort, &ex_ptr, &ex_mutex]() 
-			{
-				#ifdef __linux__
-					cpu_set_t cpuset;
-					CPU_ZERO(&cpuset);
-					CPU_SET(Is % std::thread::hardware_concurrency(), &cpuset);
-					pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset);
-				#endif
+		auto run_chunk = [&]<size_t I>()
+		{
+			if (errors.aborted()) return;
 
-				try
-				{
-					[[assume(!abort.load(std::memory_order_relaxed))]];
-					if (abort.load(std::memory_order_relaxed)) return;
-					
-					using chunk = typename chunk_of_sequence<T, N0, Nn, Ns, Is, chunk_count>::type;
-					constexpr T offset = chunk_of_sequence<T, N0, Nn, Ns, Is, chunk_count>::chunk_start;
-					for_each_index<T, offset>(chunk{}, f, Is);
-				}
-				catch (...)
-				{
-					[[assume(!abort.load(std::memory_order_relaxed))]];
-					if (!abort.load(std::memory_order_relaxed))
-					{
-						std::lock_guard<std::mutex> lock(ex_mutex);
-						if (!ex_ptr)
-						{
-							ex_ptr = std::current_exception();
-							abort.store(true, std::memory_order_relaxed);
-						}
-					}
-				}
-			})...
-		);
+			// The chunk's sequence already holds absolute indices.
+			using chunk = typename chunk_of_sequence<T, N0, Nn, Ns, I, chunk_count>::type;
+			for_each_index<T, T{0}>(chunk{}, f, I);
+		};
 
-		( [&] {
-				try 
-				{ 
-					std::get<Is>(futures).get(); 
-				}
-				catch (...) 
-				{
-					[[assume(!abort.load(std::memory_order_relaxed))]];
-					if (!abort.load(std::memory_order_relaxed))
-					{
-						std::lock_guard<std::mutex> lock(ex_mutex);
-						if (!ex_ptr)
-						{
-							ex_ptr = std::current_exception();
-							abort.store(true, std::memory_order_relaxed);
-						}
-					}
-				}
-		}(), ...);
+		// Chunk i of the compile-time split, dispatched without type-erased task storage.
+		auto task = [&](size_t i)
+		{
+			(void)((i == Is && (run_chunk.template operator()<Is>(), true)) || ...);
+		};
 
-		std::lock_guard<std::mutex> final_lock(ex_mutex);
-		if (ex_ptr) 
-			std::rethrow_exception(ex_ptr);
+		detail::run_tasks(chunk_count, task, errors);
+		errors.rethrow();
 	}
 
 	/**
@@ -391,6 +5556,256 @@ namespace async
 			std::make_index_sequence<threads>{}
 		);
 	}
+
+	/**
+	 * \brief Pack of consecutive loop indices handed to a tiled kernel, `(*this)[l] = base + l * Ns`.
+	 * \tparam T Index type
+	 * \tparam W Lanes per tile
+	 * \tparam Ns Step between lanes
+	 */
+	template <typename T, size_t W, T Ns = 1>
+	struct lanes
+	{
+		static constexpr size_t width = W;
+		static constexpr T step = Ns;
+
+		T base;           ///< Index of lane 0
+		size_t count = W; ///< Active lanes, fewer than `width` only in a chunk's last tile
+
+		constexpr T operator[](size_t l) const noexcept { return base + static_cast<T>(l) * Ns; }
+	};
+
+	namespace detail
+	{
+		/**
+		 * \brief Apply `f` to the `W` indices of the tile starting at `first`.
+		 *
+		 * Scalar bodies are unrolled across the tile, lane bodies get one `lanes` pack.
+		 */
+		template <typename T, T Ns, size_t W, typename F>
+		inline void
+		invoke_tile(F& f, T first, size_t count, size_t thread_id)
+		{
+			if constexpr (std::is_invocable_v<F, T> || std::is_invocable_v<F, T, size_t>)
+			{
+				auto scalar = [&](T i)
+				{
+					if constexpr (std::is_invocable_v<F, T>)
+						f(i);
+					else
+						f(i, thread_id);
+				};
+
+				if (count == W)
+					[&]<size_t... Ls>(std::index_sequence<Ls...>)
+					{
+						(scalar(first + static_cast<T>(Ls) * Ns), ...);
+					}(std::make_index_sequence<W>{});
+				else
+					for (size_t l = 0; l < count; ++l)
+						scalar(first + static_cast<T>(l) * Ns);
+			}
+			else if constexpr (std::is_invocable_v<F, lanes<T, W, Ns>>)
+				f(lanes<T, W, Ns>{first, count});
+			else if constexpr (std::is_invocable_v<F, lanes<T, W, Ns>, size_t>)
+				f(lanes<T, W, Ns>{first, count}, thread_id);
+			else 
+				static_assert(false, "`f` must be invocable with (T), (T, size_t), (lanes<T, W, Ns>) or (lanes<T, W, Ns>, size_t)");
+		}
+	}
+
+	/**
+	 * \brief async for_each kernel over compile-time chunks, unrolled one tile at a time.
+	 */
+	template <typename T, T N0, T Nn, T Ns, size_t W, typename F, size_t... Is>
+	inline void 
+	async_for_each_tiled_index(F&& f, std::index_sequence<Is...>)
+	{
+		static_assert(W > 0, "tile width must be positive");
+		static constexpr size_t chunk_count = sizeof...(Is);
+
+		detail::error_state errors;
+
+		auto run_chunk = [&]<size_t I>()
+		{
+			using chunk = chunk_of_sequence<T, N0, Nn, Ns, I, chunk_count>;
+			constexpr size_t count = chunk::count;
+
+			for (size_t t = 0; t < count; t += W)
+			{
+				if (errors.aborted()) return;
+				detail::invoke_tile<T, Ns, W>(f, chunk::chunk_start + static_cast<T>(t) * Ns, 
+					std::min(W, count - t), I);
+			}
+		};
+
+		auto task = [&](size_t i)
+		{
+			(void)((i == Is && (run_chunk.template operator()<Is>(), true)) || ...);
+		};
+
+		detail::run_tasks(chunk_count, task, errors);
+
+		errors.rethrow();
+	}
+
+	/**
+	 * \brief Compile-time indexed async loop, unrolled `W` indices at a time.
+	 *
+	 * Chunk bounds and the tile width are compile-time constants as in the fully 
+	 * unrolled `async_for_each<T, N0, Nn, Ns>`, but each chunk is a loop over tiles,
+	 * so code size no longer grows with the index space. `f` takes either a
+	 * scalar index, called `W` times per tile, or a `lanes<T, W, Ns>` pack.
+	 *
+	 * \tparam T Index type (usually size_t)
+	 * \tparam N0 Start index (inclusive)
+	 * \tparam Nn End index (exclusive)
+	 * \tparam Ns Step size
+	 * \tparam W Tile width
+	 * \tparam threads Number of parallel threads
+	 * \tparam F Callable type
+	 * \param f Function to call for each index or tile
+	 */
+	template <typename T, const T N0, const T Nn, const T Ns, const size_t W = 8, const size_t threads = threads, typename F>
+	inline void 
+	async_for_each_tiled(F&& f)
+	{
+		async_for_each_tiled_index<T, N0, Nn, Ns, W>(
+			std::forward<F>(f),
+			std::make_index_sequence<threads>{}
+		);
+	}
+
+	namespace detail
+	{
+		/// Compile-time list of extents, as a type.
+		template <size_t... Ns>
+		struct extents
+		{
+			static constexpr std::array<size_t, sizeof...(Ns)> value{Ns...};
+		};
+	}
+
+	/**
+	 * \brief async kernel over the tiles of a compile-time N-dimensional index space.
+	 *
+	 * Chunk `I` of the tile sequence is bounded as in `chunk_of_sequence`; full
+	 * tiles run with compile-time extents so their loops can be unrolled.
+	 */
+	template <typename Extent, typename Tile, typename F, size_t... Is>
+	inline void 
+	async_for_each_nd_index(F&& f, std::index_sequence<Is...>)
+	{
+		static constexpr size_t chunk_count = sizeof...(Is);
+		static constexpr auto extent = Extent::value;
+		static constexpr auto tile = Tile::value;
+		static constexpr size_t N = extent.size();
+		static constexpr size_t tiles = []
+		{
+			size_t n = 1;
+			for (size_t d = 0; d < N; ++d)
+				n *= (extent[d] + tile[d] - 1) / tile[d];
+			return n;
+		}();
+
+		detail::error_state errors;
+
+		auto run_chunk = [&]<size_t I>()
+		{
+			using chunk = chunk_of_sequence<size_t, 0, tiles, 1, I, chunk_count>;
+			std::array<size_t, N> lo, hi;
+
+			for (size_t t = chunk::chunk_start; t < chunk::chunk_end; ++t)
+			{
+				if (errors.aborted()) return;
+				detail::tile_bounds<N>(t, extent, tile, lo, hi);
+
+				bool full = true;
+				for (size_t d = 0; d < N; ++d)
+					full = full && hi[d] - lo[d] == tile[d];
+
+				if (full)
+				{
+					if constexpr (N == 2)
+					{
+						for (size_t a = 0; a < tile[0]; ++a)
+							for (size_t b = 0; b < tile[1]; ++b)
+								detail::invoke_nd<2>(f, I, lo[0] + a, lo[1] + b);
+					}
+					else
+					{
+						for (size_t a = 0; a < tile[0]; ++a)
+							for (size_t b = 0; b < tile[1]; ++b)
+								for (size_t c = 0; c < tile[2]; ++c)
+									detail::invoke_nd<3>(f, I, lo[0] + a, lo[1] + b, lo[2] + c);
+					}
+				}
+				else
+					detail::for_each_box<N>(f, lo, hi, I);
+			}
+		};
+
+		auto task = [&](size_t i)
+		{
+			(void)((i == Is && (run_chunk.template operator()<Is>(), true)) || ...);
+		};
+
+		detail::run_tasks(chunk_count, task, errors);
+		errors.rethrow();
+	}
+
+	/**
+	 * \brief Compile-time tiled loop over `[0, R) x [0, C)`.
+	 *
+	 * The tile grid, and each chunk of it, are compile-time constants in the
+	 * manner of `async_for_each<T, N0, Nn, Ns>`; `f` is invoked as `f(i, j)` or 
+	 * `f(i, j, thread_id)`.
+	 *
+	 * \tparam R Extent of `i`
+	 * \tparam C Extent of `j`, the innermost index
+	 * \tparam TR Tile rows
+	 * \tparam TC Tile columns
+	 * \tparam threads Number of parallel threads
+	 * \tparam F Callable type
+	 * \param f Function to call for each index pair
+	 */
+	template <size_t R, size_t C, size_t TR = 8, size_t TC = 8, const size_t threads = threads, typename F>
+	inline void 
+	async_for_each_2d(F&& f)
+	{
+		static_assert(R > 0 && C > 0 && TR > 0 && TC > 0, "extents and tile shape must be positive");
+		async_for_each_nd_index<detail::extents<R, C>, detail::extents<std::min(TR, R), std::min(TC, C)>>(
+			std::forward<F>(f),
+			std::make_index_sequence<threads>{}
+		);
+	}
+
+	/**
+	 * \brief Compile-time tiled loop over `[0, D) x [0, R) x [0, C)`.
+	 * \see async_for_each_2d()
+	 *
+	 * \tparam D Extent of `i`
+	 * \tparam R Extent of `j`
+	 * \tparam C Extent of `k`, the innermost index
+	 * \tparam TD Tile depth
+	 * \tparam TR Tile rows
+	 * \tparam TC Tile columns
+	 * \tparam threads Number of parallel threads
+	 * \tparam F Callable type
+	 * \param f Function to call for each index triple
+	 */
+	template <size_t D, size_t R, size_t C, size_t TD = 4, size_t TR = 4, size_t TC = 8, 
+				const size_t threads = threads, typename F>
+	inline void 
+	async_for_each_3d(F&& f)
+	{
+		static_assert(D > 0 && R > 0 && C > 0 && TD > 0 && TR > 0 && TC > 0, "extents and tile shape must be positive");
+		async_for_each_nd_index<detail::extents<D, R, C>, 
+			detail::extents<std::min(TD, D), std::min(TR, R), std::min(TC, C)>>(
+			std::forward<F>(f),
+			std::make_index_sequence<threads>{}
+		);
+	}
 }//namespace async
 
 #endif // __ASYNC_H__
\ No newline at end of file
@@ -6,6 +6,21 @@
 #include <cassert>
 #include <stdexcept>
 #include <cmath>
+#include <set>
+#include <thread>
+#include <list>
+#include <deque>
+#include <span>
+#include <memory>
+#include <numeric>
+#include <mutex>
+#include <map>
+#include <ranges>
+#include <tuple>
+#include <new>
+#include <cstdlib>
+#include <fstream>
+#include <filesystem>
 #include <async.h>
 #include <tbb/parallel_for.h>
 #include <tbb/blocked_range.h>
@@ -36,60 +51,1546 @@
 
 using namespace async;
 
+// Heap allocations made through operator new, for the allocation-free dispatch test.
+static std::atomic<size_t> allocations{0};
+
+void* operator new(std::size_t size)
+{
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	if (void* p = std::malloc(size ? size : 1))
+		return p;
+	throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, std::align_val_t align)
+{
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	size_t alignment = static_cast<size_t>(align);
+	if (void* p = std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment))
+		return p;
+	throw std::bad_alloc();
+}
+
+// Out of line, so the compiler does not see free() paired with new.
+[[gnu::noinline]] void operator delete(void* p) noexcept { std::free(p); }
+[[gnu::noinline]] void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+[[gnu::noinline]] void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+[[gnu::noinline]] void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+
 // Original async_for_each tests
 double test_dynamic_dispatch() 
 {
-	std::vector<size_t> numbers(TEST_SIZE, 0);
-	std::atomic<size_t> counter{0};
+	std::vector<size_t> numbers(TEST_SIZE, 0);
+	std::atomic<size_t> counter{0};
+
+	async_for_each(numbers.begin(), numbers.end(),
+		[&counter](size_t& val, size_t idx)
+		{
+			val = idx;
+			counter++;
+		});
+
+	assert(counter.load() == TEST_SIZE);
+	return 0;
+}
+
+double test_compile_time_dispatch() 
+{
+	std::atomic<size_t> counter{0};
+
+	async_for_each<size_t, 0, TEST_SIZE, 1>(
+		[&counter](size_t idx)
+		{
+			counter++;
+		});
+
+	assert(counter.load() == TEST_SIZE);
+	return 0;
+}
+
+double test_compile_time_indices()
+{
+	std::vector<std::atomic<size_t>> seen(20);
+
+	async_for_each<size_t, 3, 20, 3, 2>(
+		[&seen](size_t idx)
+		{
+			seen[idx]++;
+		});
+
+	for (size_t i = 0; i < seen.size(); ++i)
+		assert(seen[i].load() == ((i >= 3 && (i - 3) % 3 == 0) ? 1 : 0));
+	return 0;
+}
+
+double test_exception_handling() 
+{
+	std::vector<size_t> numbers(TEST_SIZE, 0);
+
+	try
+	{
+		async_for_each(numbers.begin(), numbers.end(),
+			[](size_t& val, size_t idx)
+			{
+				if (idx == TEST_SIZE / 2)
+				{
+					throw std::runtime_error("test exception");
+				}
+				val = idx;
+			});
+		assert(false && "Expected exception was not thrown");
+	}
+	catch (const std::runtime_error& e)
+	{
+		std::cout << "Caught expected exception: " << e.what() << std::endl;
+	}
+
+	return 0.0;
+}
+
+double test_thread_pool_reuse()
+{
+	std::vector<size_t> numbers(TEST_SIZE, 0);
+	std::set<std::thread::id> ids;
+	std::mutex ids_mutex;
+
+	for (int run = 0; run < 16; ++run)
+	{
+		async_for_each(numbers.begin(), numbers.end(),
+			[&](size_t& val)
+			{
+				val++;
+				std::lock_guard<std::mutex> lock(ids_mutex);
+				ids.insert(std::this_thread::get_id());
+			});
+	}
+
+	// Workers are persistent, the caller may help while it waits.
+	assert(ids.size() <= thread_pool::instance().size() + 1);
+	assert(std::all_of(numbers.begin(), numbers.end(), [](size_t v) { return v == 16; }));
+	return 0;
+}
+
+double test_work_stealing()
+{
+	std::vector<double> data(TEST_SIZE, 0.0);
+	std::vector<size_t> seen(TEST_SIZE, 0);
+	std::atomic<size_t> counter{0};
+
+	// Irregular cost: every 64th element is 100x more expensive.
+	async_for_each(stealing_partitioner{4}, data.begin(), data.end(),
+		[&](double& val, size_t idx, size_t thread_id)
+		{
+			int work = (idx % 64 == 0) ? 10000 : 100;
+			for (int i = 0; i < work; ++i)
+				val += std::sin(static_cast<double>(idx + i));
+			seen[idx]++;
+			counter++;
+			assert(thread_id < runtime_threads());
+		});
+
+	assert(counter.load() == TEST_SIZE);
+	assert(std::all_of(seen.begin(), seen.end(), [](size_t n) { return n == 1; }));
+
+	try
+	{
+		async_for_each(stealing_partitioner{}, data.begin(), data.end(),
+			[](double&, size_t idx)
+			{
+				if (idx == TEST_SIZE / 3) throw std::runtime_error("test exception");
+			});
+		assert(false && "Expected exception was not thrown");
+	}
+	catch (const std::runtime_error&) {}
+
+	return 0;
+}
+
+template<typename Pt>
+void check_partitioner(Pt part)
+{
+	std::vector<size_t> numbers(TEST_SIZE + 3, 0);
+	std::atomic<size_t> counter{0};
+
+	async_for_each(part, numbers.begin(), numbers.end(),
+		[&](size_t& val, size_t idx)
+		{
+			val = idx;
+			counter++;
+		});
+
+	assert(counter.load() == numbers.size());
+	if constexpr (!std::is_same_v<Pt, static_partitioner>)
+		for (size_t i = 0; i < numbers.size(); ++i)
+			assert(numbers[i] == i);
+}
+
+double test_partitioners()
+{
+	check_partitioner(static_partitioner{});
+	check_partitioner(dynamic_partitioner{});
+	check_partitioner(dynamic_partitioner{.grain = 100});
+	check_partitioner(guided_partitioner{});
+	check_partitioner(guided_partitioner{.grain = 16});
+	check_partitioner(stealing_partitioner{});
+	return 0;
+}
+
+double test_reduce()
+{
+	std::vector<size_t> numbers(TEST_SIZE + 3);
+	std::iota(numbers.begin(), numbers.end(), 1);
+	const size_t n = numbers.size();
+
+	assert(async_reduce(numbers.begin(), numbers.end(), size_t(0)) == n * (n + 1) / 2);
+	assert(async_reduce(guided_partitioner{}, numbers.begin(), numbers.end(), size_t(0)) == n * (n + 1) / 2);
+	assert(async_reduce(numbers.begin(), numbers.begin(), size_t(7)) == 7);
+
+	auto max = async_reduce(stealing_partitioner{}, numbers.begin(), numbers.end(), size_t(0),
+		[](size_t a, size_t b) { return std::max(a, b); });
+	assert(max == n);
+
+	auto squares = async_transform_reduce(dynamic_partitioner{.grain = 64}, numbers.begin(), numbers.end(), 
+		size_t(0), std::plus<>{}, [](size_t x) { return x * x; });
+	assert(squares == n * (n + 1) * (2 * n + 1) / 6);
+
+	std::list<size_t> list(numbers.begin(), numbers.end());
+	assert(async_reduce(list.begin(), list.end(), size_t(0)) == n * (n + 1) / 2);
+
+	return 0;
+}
+
+double test_scan()
+{
+	std::vector<size_t> numbers(TEST_SIZE + 3);
+	std::iota(numbers.begin(), numbers.end(), 1);
+	std::vector<size_t> expected(numbers.size()), out(numbers.size());
+
+	std::inclusive_scan(numbers.begin(), numbers.end(), expected.begin());
+	auto last = async_inclusive_scan(numbers.begin(), numbers.end(), out.begin());
+	assert(last == out.end());
+	assert(out == expected);
+
+	std::exclusive_scan(numbers.begin(), numbers.end(), expected.begin(), size_t(10));
+	async_exclusive_scan(numbers.begin(), numbers.end(), out.begin(), size_t(10));
+	assert(out == expected);
+
+	// In place
+	async_exclusive_scan(numbers.begin(), numbers.end(), numbers.begin(), size_t(10));
+	assert(numbers == expected);
+
+	std::vector<size_t> one{5};
+	async_inclusive_scan(one.begin(), one.end(), one.begin());
+	assert(one[0] == 5);
+
+	return 0;
+}
+
+double test_chunk_dispatch()
+{
+	std::vector<float> data(TEST_SIZE + 3, 1.0f);
+	std::atomic<size_t> counter{0};
+
+	async_for_each_chunk(data.begin(), data.end(),
+		[&](std::span<float> chunk, size_t first, size_t thread_id)
+		{
+			assert(thread_id < runtime_threads());
+			for (size_t i = 0; i < chunk.size(); ++i)
+				chunk[i] = static_cast<float>(first + i);
+			counter += chunk.size();
+		});
+
+	assert(counter.load() == data.size());
+	for (size_t i = 0; i < data.size(); ++i)
+		assert(data[i] == static_cast<float>(i));
+
+	std::deque<size_t> deque(TEST_SIZE, 1);
+	std::atomic<size_t> sum{0};
+	async_for_each_chunk(dynamic_partitioner{.grain = 100}, deque.begin(), deque.end(),
+		[&](auto chunk)
+		{
+			size_t local = 0;
+			for (size_t v : chunk) local += v;
+			sum += local;
+		});
+	assert(sum.load() == TEST_SIZE);
+
+	std::list<size_t> list(TEST_SIZE, 1);
+	sum = 0;
+	async_for_each_chunk(list.begin(), list.end(),
+		[&](auto chunk)
+		{
+			for (size_t v : chunk) sum += v;
+		});
+	assert(sum.load() == TEST_SIZE);
+
+	return 0;
+}
+
+double test_tiled_dispatch()
+{
+	constexpr size_t N = 100000;
+	std::vector<size_t> out(N, 0);
+
+	async_for_each_tiled<size_t, 0, N, 1, 16>(
+		[&out](size_t idx, size_t thread_id)
+		{
+			out[idx] = idx + 1;
+		});
+
+	for (size_t i = 0; i < N; ++i)
+		assert(out[i] == i + 1);
+
+	std::atomic<size_t> sum{0}, counter{0};
+	async_for_each_tiled<size_t, 5, 1000, 7, 4>(
+		[&](lanes<size_t, 4, 7> tile)
+		{
+			size_t local = 0;
+			for (size_t l = 0; l < tile.count; ++l)
+				local += tile[l];
+			sum += local;
+			counter += tile.count;
+		});
+
+	size_t expected = 0, count = 0;
+	for (size_t i = 5; i < 1000; i += 7, ++count)
+		expected += i;
+	assert(counter.load() == count);
+	assert(sum.load() == expected);
+
+	return 0;
+}
+
+double test_numa()
+{
+	assert((topology::parse_list("0-3,8,10-11\n") == std::vector<int>{0, 1, 2, 3, 8, 10, 11}));
+
+	const auto& topo = topology::instance();
+	assert(topo.nodes() >= 1);
+	assert(topo.scatter().size() == topo.cpu_count());
+
+	constexpr size_t n = TEST_SIZE + 3;
+	auto buffer = std::make_unique_for_overwrite<size_t[]>(n);
+	async_first_touch(buffer.get(), buffer.get() + n, size_t(1));
+	assert(std::all_of(buffer.get(), buffer.get() + n, [](size_t v) { return v == 1; }));
+
+	const auto& pool = thread_pool::instance();
+	std::atomic<size_t> counter{0};
+	async_for_each(numa_partitioner{}, buffer.get(), buffer.get() + n,
+		[&](size_t& val, size_t idx, size_t thread_id)
+		{
+			assert(idx < n);
+			val += idx;
+			counter++;
+		});
+	assert(counter.load() == n);
+	for (size_t i = 0; i < n; ++i)
+		assert(buffer[i] == i + 1);
+
+	for (size_t w = 0; w < pool.size(); ++w)
+		assert(pool.node_of(w) == topo.node_of(pool.cpu_of(w)));
+
+	return 0;
+}
+
+double test_affinity()
+{
+	assert(affinity::parse("none").mode == affinity::policy::none);
+	assert(affinity::parse("compact").mode == affinity::policy::compact);
+	assert(affinity::parse("bogus").mode == affinity::policy::scatter);
+	auto list = affinity::parse("0,2-3");
+	assert(list.mode == affinity::policy::list);
+	assert((list.cpus == std::vector<int>{0, 2, 3}));
+
+	const auto& allowed = topology::instance().allowed();
+	for (int cpu : affinity{affinity::policy::compact, {}}.placement(8))
+		assert(std::find(allowed.begin(), allowed.end(), cpu) != allowed.end());
+	assert((affinity{affinity::policy::none, {}}.placement(3) == std::vector<int>(3, -1)));
+
+	auto& pool = thread_pool::instance();
+	pool.set_affinity({affinity::policy::none, {}});
+	for (size_t w = 0; w < pool.size(); ++w)
+		assert(pool.cpu_of(w) == -1);
+
+	std::vector<size_t> numbers(TEST_SIZE, 1);
+	assert(async_reduce(numbers.begin(), numbers.end(), size_t(0)) == TEST_SIZE);
+
+	pool.set_affinity(affinity::from_env());
+	return 0;
+}
+
+double test_nested_parallelism()
+{
+	std::vector<std::vector<size_t>> batches(8, std::vector<size_t>(TEST_SIZE / 8, 0));
+	std::set<std::thread::id> ids;
+	std::mutex ids_mutex;
+	auto& pool = thread_pool::instance();
+
+	async_for_each(batches.begin(), batches.end(),
+		[&](std::vector<size_t>& batch)
+		{
+			async_for_each(batch.begin(), batch.end(),
+				[&](size_t& val)
+				{
+					val++;
+					std::lock_guard<std::mutex> lock(ids_mutex);
+					ids.insert(std::this_thread::get_id());
+				}, 8);
+		}, 8);
+
+	assert(ids.size() <= pool.size() + 1);
+	for (const auto& batch : batches)
+		assert(std::all_of(batch.begin(), batch.end(), [](size_t v) { return v == 1; }));
+
+	pool.set_nesting(nesting::serial);
+	async_for_each(batches.begin(), batches.end(),
+		[&](std::vector<size_t>& batch)
+		{
+			auto outer = std::this_thread::get_id();
+			bool in_worker = pool.in_worker();
+			async_for_each(batch.begin(), batch.end(),
+				[&](size_t& val)
+				{
+					val++;
+					assert(!in_worker || std::this_thread::get_id() == outer);
+				});
+		});
+	pool.set_nesting(nesting::shared);
+
+	for (const auto& batch : batches)
+		assert(std::all_of(batch.begin(), batch.end(), [](size_t v) { return v == 2; }));
+	return 0;
+}
+
+double test_launch_handle()
+{
+	std::vector<size_t> a(TEST_SIZE, 0), b(TEST_SIZE, 0);
+
+	auto ha = async_launch_for_each(a.begin(), a.end(), [](size_t& val, size_t idx) { val = idx; });
+	auto hb = async_launch_for_each(stealing_partitioner{}, b.begin(), b.end(), [](size_t& val) { val = 7; });
+	assert(ha.valid() && hb.valid());
+
+	hb.wait();
+	ha.wait();
+	assert(ha.is_ready() && ha.wait_for(std::chrono::milliseconds(0)));
+	for (size_t i = 0; i < a.size(); ++i)
+		assert(a[i] == i && b[i] == 7);
+
+	std::list<size_t> list(TEST_SIZE, 0);
+	auto hl = async_launch_for_each(list.begin(), list.end(), [](size_t& val) { val = 1; });
+	hl.wait();
+	assert(std::all_of(list.begin(), list.end(), [](size_t v) { return v == 1; }));
+
+	// Partitioned list loops walk the nodes on the pool, with exact indices.
+	auto hp = async_launch_for_each(dynamic_partitioner{.grain = 16}, list.begin(), list.end(), [](size_t& val, size_t idx) { val = idx; });
+	hp.wait();
+	size_t expected = 0;
+	for (size_t v : list)
+		assert(v == expected++);
+
+	auto he = async_launch_for_each(a.begin(), a.begin(), [](size_t&) {});
+	assert(he.is_ready());
+	auto hle = async_launch_for_each(guided_partitioner{}, list.end(), list.end(), [](size_t&) {});
+	assert(hle.is_ready());
+
+	auto hx = async_launch_for_each(dynamic_partitioner{}, a.begin(), a.end(),
+		[](size_t&, size_t idx)
+		{
+			if (idx == TEST_SIZE / 2) throw std::runtime_error("test exception");
+		});
+	try
+	{
+		hx.wait();
+		assert(false && "Expected exception was not thrown");
+	}
+	catch (const std::runtime_error&) {}
+
+	return 0;
+}
+
+task<size_t> coroutine_sum(std::vector<size_t>& numbers)
+{
+	co_await async_launch_for_each(numbers.begin(), numbers.end(), [](size_t& val, size_t idx) { val = idx; });
+	co_return co_await async_launch_reduce(numbers.begin(), numbers.end(), size_t(0));
+}
+
+task<> coroutine_throws(std::vector<size_t>& numbers)
+{
+	co_await async_launch_for_each(numbers.begin(), numbers.end(),
+		[](size_t&, size_t idx)
+		{
+			if (idx == TEST_SIZE / 2) throw std::runtime_error("test exception");
+		});
+}
+
+task<size_t> coroutine_outer(std::vector<size_t>& numbers)
+{
+	size_t sum = co_await coroutine_sum(numbers);
+	try
+	{
+		co_await coroutine_throws(numbers);
+	}
+	catch (const std::runtime_error&)
+	{
+		sum += 1;
+	}
+	co_return sum;
+}
+
+double test_coroutines()
+{
+	std::vector<size_t> numbers(TEST_SIZE, 0);
+
+	size_t sum = sync_wait(coroutine_outer(numbers));
+	assert(sum == TEST_SIZE * (TEST_SIZE - 1) / 2 + 1);
+
+	// Tasks finishing on a worker while the caller is still waking: the frame must outlive the signal.
+	std::vector<size_t> small(64, 0);
+	for (int run = 0; run < 500; ++run)
+		assert(sync_wait(coroutine_sum(small)) == 64 * 63 / 2);
+
+	auto handle = async_launch_transform_reduce(dynamic_partitioner{.grain = 32}, numbers.begin(), numbers.end(), 
+		size_t(0), std::plus<>{}, [](size_t) { return size_t(1); });
+	assert(handle.get() == TEST_SIZE);
+
+	return 0;
+}
+
+double test_task_graph()
+{
+	std::vector<size_t> decoded(TEST_SIZE, 0), transformed(TEST_SIZE, 0);
+	std::atomic<size_t> total{0};
+	std::vector<int> order;
+	std::mutex order_mutex;
+	auto record = [&](int stage)
+	{
+		std::lock_guard<std::mutex> lock(order_mutex);
+		order.push_back(stage);
+	};
+
+	task_graph graph;
+	auto decode = graph.emplace_for_each(decoded.begin(), decoded.end(), [](size_t& val, size_t idx) { val = idx; });
+	auto transform = graph.emplace_for_each(dynamic_partitioner{.grain = 64}, transformed.begin(), transformed.end(),
+		[&decoded](size_t& val, size_t idx) { val = decoded[idx] * 2; });
+	auto reduce = graph.emplace([&] 
+	{ 
+		total += async_reduce(transformed.begin(), transformed.end(), size_t(0)); 
+		record(2);
+	});
+	auto side = graph.emplace([&] { record(1); });
+	graph.precede(decode, transform);
+	graph.precede(transform, reduce);
+	graph.precede(decode, side);
+
+	for (int run = 0; run < 3; ++run)
+		graph.run();
+
+	assert(total.load() == 3 * TEST_SIZE * (TEST_SIZE - 1));
+	assert(order.size() == 6);
+
+	// A failing node skips the nodes that depend on it.
+	task_graph failing;
+	bool ran = false;
+	auto first = failing.emplace([] { throw std::runtime_error("test exception"); });
+	auto second = failing.emplace([&] { ran = true; });
+	failing.precede(first, second);
+	try
+	{
+		failing.run();
+		assert(false && "Expected exception was not thrown");
+	}
+	catch (const std::runtime_error&) {}
+	assert(!ran);
+
+	failing.precede(second, first);
+	try
+	{
+		failing.run();
+		assert(false && "Expected cycle was not detected");
+	}
+	catch (const std::logic_error&) {}
+
+	return 0;
+}
+
+double test_pipeline()
+{
+	bounded_queue<int> queue(3);
+	assert(queue.capacity() == 4);
+	for (int i = 0; i < 4; ++i)
+		assert(queue.try_push(i));
+	assert(!queue.try_push(4));
+	int value;
+	for (int i = 0; i < 4; ++i)
+		assert(queue.try_pop(value) && value == i);
+	assert(!queue.try_pop(value));
+
+	struct item
+	{
+		size_t seq;
+		size_t squared;
+	};
+
+	size_t produced = 0;
+	std::atomic<size_t> peak{0}, live{0};
+	std::vector<size_t> sunk;
+	std::set<size_t> unordered;
+
+	pipeline<item> p(4);
+	p.source([&](item& it)
+		{
+			if (produced == TEST_SIZE) return false;
+			it.seq = produced++;
+			size_t now = ++live;
+			size_t prev = peak.load();
+			while (now > prev && !peak.compare_exchange_weak(prev, now));
+			return true;
+		})
+		.stage(stage_mode::parallel, [](item& it) { it.squared = it.seq * it.seq; })
+		.stage(stage_mode::serial_out_of_order, [&](item& it) { unordered.insert(it.seq); })
+		.stage(stage_mode::serial_in_order, [&](item& it)
+		{
+			assert(it.squared == it.seq * it.seq);
+			sunk.push_back(it.seq);
+			--live;
+		});
+
+	for (int run = 0; run < 2; ++run)
+	{
+		produced = 0;
+		sunk.clear();
+		unordered.clear();
+		p.run();
+		assert(sunk.size() == TEST_SIZE);
+		assert(unordered.size() == TEST_SIZE);
+		for (size_t i = 0; i < TEST_SIZE; ++i)
+			assert(sunk[i] == i);
+	}
+	assert(peak.load() <= 4);
+
+	// A failing stage stops the pipeline and rethrows.
+	pipeline<size_t> failing(2);
+	size_t count = 0;
+	failing.source([&](size_t& v) { v = count++; return true; })
+		.stage(stage_mode::parallel, [](size_t& v) { if (v == 100) throw std::runtime_error("test exception"); });
+	try
+	{
+		failing.run();
+		assert(false && "Expected exception was not thrown");
+	}
+	catch (const std::runtime_error&) {}
+
+	return 0;
+}
+
+double test_forward_iterators()
+{
+	std::list<size_t> list(TEST_SIZE + 3, 0);
+	async_for_each(list.begin(), list.end(), [](size_t& val, size_t idx) { val = idx; });
+	size_t expected = 0;
+	for (size_t v : list)
+		assert(v == expected++);
+
+	std::atomic<size_t> completed{0};
+	async_for_each(dynamic_partitioner{.grain = 7}, list.begin(), list.end(),
+		[](size_t& val, size_t idx) { val += idx; }, runtime_threads(),
+		[&](size_t count) { completed = count; });
+	expected = 0;
+	for (size_t v : list)
+		assert(v == 2 * expected++);
+	assert(completed.load() >= 1);
+
+	std::map<size_t, size_t> map;
+	for (size_t i = 0; i < 1000; ++i)
+		map[i] = 0;
+	async_for_each(guided_partitioner{}, map.begin(), map.end(),
+		[](auto& kv, size_t idx) { kv.second = kv.first + idx; });
+	for (const auto& [k, v] : map)
+		assert(v == 2 * k);
+
+	std::atomic<size_t> chunks{0}, nodes{0};
+	async_for_each_chunk(dynamic_partitioner{.grain = 100}, map.begin(), map.end(),
+		[&](auto chunk, size_t first)
+		{
+			assert(chunk.begin()->first == first);
+			chunks++;
+			nodes += std::ranges::distance(chunk);
+		});
+	assert(chunks.load() == 10 && nodes.load() == 1000);
+
+	std::list<size_t> empty;
+	async_for_each(empty.begin(), empty.end(), [](size_t&) { assert(false); });
+
+	return 0;
+}
+
+double test_algorithms()
+{
+	const size_t n = 100003;
+	std::vector<size_t> numbers(n), out(n);
+	std::iota(numbers.begin(), numbers.end(), 0);
+
+	auto end = async_transform(numbers.begin(), numbers.end(), out.begin(), [](size_t x) { return 2 * x; });
+	assert(end == out.end());
+	for (size_t i = 0; i < n; ++i)
+		assert(out[i] == 2 * i);
+
+	async_transform(dynamic_partitioner{.grain = 64}, numbers.begin(), numbers.end(), out.begin(), out.begin(),
+		[](size_t a, size_t b) { return a + b; });
+	for (size_t i = 0; i < n; ++i)
+		assert(out[i] == 3 * i);
+
+	async_fill(out.begin(), out.end(), size_t(7));
+	assert(std::all_of(out.begin(), out.end(), [](size_t v) { return v == 7; }));
+	async_fill(guided_partitioner{}, out.begin(), out.end(), size_t(9));
+	assert(std::all_of(out.begin(), out.end(), [](size_t v) { return v == 9; }));
+
+	auto every_third = [](size_t x) { return x % 3 == 1; };
+	std::vector<size_t> expected;
+	std::copy_if(numbers.begin(), numbers.end(), std::back_inserter(expected), every_third);
+	auto copied = async_copy_if(numbers.begin(), numbers.end(), out.begin(), every_third);
+	assert(static_cast<size_t>(copied - out.begin()) == expected.size());
+	assert(std::equal(expected.begin(), expected.end(), out.begin()));
+
+	std::vector<size_t> shuffled(n);
+	for (size_t i = 0; i < n; ++i)
+		shuffled[i] = (i * 7919) % n;
+	async_sort(shuffled.begin(), shuffled.end());
+	assert(shuffled == numbers);
+	async_sort(shuffled.begin(), shuffled.end(), std::greater<>{}, 3);
+	assert(std::is_sorted(shuffled.begin(), shuffled.end(), std::greater<>{}));
+
+	std::vector<size_t> small = {5, 3, 9, 1};
+	async_sort(small.begin(), small.end());
+	assert(std::is_sorted(small.begin(), small.end()));
+
+	// The first match wins, and elements far past it are never tested.
+	std::atomic<size_t> tested{0};
+	auto it = async_find_if(dynamic_partitioner{.grain = 16}, numbers.begin(), numbers.end(),
+		[&](size_t x) { tested++; return x >= 100 && x % 50 == 0; });
+	assert(it != numbers.end() && *it == 100);
+	assert(tested.load() < n);
+	assert(async_find_if(numbers.begin(), numbers.end(), [](size_t x) { return x == n - 1; }) == numbers.end() - 1);
+	assert(async_find_if(numbers.begin(), numbers.end(), [](size_t x) { return x == n; }) == numbers.end());
+
+	tested = 0;
+	assert(async_any_of(dynamic_partitioner{.grain = 16}, numbers.begin(), numbers.end(),
+		[&](size_t x) { tested++; return x == 10; }));
+	assert(tested.load() < n);
+	assert(!async_any_of(numbers.begin(), numbers.end(), [](size_t x) { return x == n; }));
+
+	try
+	{
+		async_any_of(numbers.begin(), numbers.end(), 
+			[](size_t x) -> bool { if (x == n / 2) throw std::runtime_error("test exception"); return false; });
+		assert(false && "Expected exception was not thrown");
+	}
+	catch (const std::runtime_error&) {}
+
+	// A predicate failing after another one matched is still reported.
+	std::vector<size_t> pair(64);
+	std::iota(pair.begin(), pair.end(), size_t{0});
+	std::atomic<bool> failing{false}, matched{false};
+	bool rethrown = false;
+	try
+	{
+		async_any_of(pair.begin(), pair.end(), [&](size_t x) -> bool
+			{
+				if (x == pair.size() / 2)
+				{
+					while (!failing.load()) std::this_thread::yield();
+					matched = true;
+					return true;
+				}
+				if (x == 0)
+				{
+					failing = true;
+					while (!matched.load()) std::this_thread::yield();
+					std::this_thread::sleep_for(std::chrono::milliseconds(20));
+					throw std::runtime_error("late failure");
+				}
+				return false;
+			}, 2);
+	}
+	catch (const std::runtime_error&) { rethrown = true; }
+	assert(rethrown);
+
+	return 0;
+}
+
+double test_cancellation()
+{
+	std::vector<size_t> data(TEST_SIZE * 64, 0);
+
+	auto done = async_for_each(cancellation{}, data.begin(), data.end(), [](size_t& val, size_t idx) { val = idx; });
+	assert(done && done.status == loop_status::completed && done.processed == data.size());
+	for (size_t i = 0; i < data.size(); ++i)
+		assert(data[i] == i);
+
+	// A stop requested from inside stops the loop short, without an exception.
+	std::stop_source source;
+	std::atomic<size_t> visited{0};
+	auto stopped = async_for_each(cancellation{.token = source.get_token(), .poll = 16}, dynamic_partitioner{.grain = 32}, 
+		data.begin(), data.end(),
+		[&](size_t&)
+		{
+			if (++visited == 1000) source.request_stop();
+		});
+	assert(!stopped && stopped.status == loop_status::cancelled);
+	assert(stopped.processed == visited.load() && stopped.processed < data.size());
+
+	// An already stopped token runs nothing.
+	auto none = async_for_each(cancellation{.token = source.get_token()}, data.begin(), data.end(), 
+		[](size_t&) { assert(false); });
+	assert(none.status == loop_status::cancelled && none.processed == 0);
+
+	auto late = async_for_each(cancellation{.deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(5), .poll = 8},
+		data.begin(), data.end(), [](size_t&) { std::this_thread::sleep_for(std::chrono::microseconds(50)); });
+	assert(late.status == loop_status::timed_out && late.processed < data.size());
+
+	std::list<size_t> list(TEST_SIZE, 0);
+	std::stop_source list_source;
+	auto partial = async_for_each(cancellation{.token = list_source.get_token(), .poll = 1}, list.begin(), list.end(),
+		[&](size_t& val, size_t idx)
+		{
+			val = 1;
+			if (idx == 10) list_source.request_stop();
+		});
+	assert(partial.status == loop_status::cancelled);
+	assert(partial.processed == static_cast<size_t>(std::count(list.begin(), list.end(), 1)));
+
+	// A body failing after a stop still has its exception reported.
+	detail::error_state stopped_errors;
+	stopped_errors.stop();
+	try { throw std::runtime_error("after stop"); }
+	catch (...) { stopped_errors.capture(); }
+	assert(stopped_errors.aborted() && stopped_errors.ex_ptr);
+
+	std::vector<size_t> pair(64, 0);
+	std::stop_source fail_source;
+	std::atomic<bool> failing{false};
+	bool rethrown = false;
+	try
+	{
+		async_for_each(cancellation{.token = fail_source.get_token(), .poll = 1}, pair.begin(), pair.end(),
+			[&](size_t&, size_t idx)
+			{
+				if (idx == pair.size() / 2)
+				{
+					while (!failing.load()) std::this_thread::yield();
+					fail_source.request_stop(); // observed when this element returns
+				}
+				if (idx == 0)
+				{
+					failing = true;
+					while (!fail_source.stop_requested()) std::this_thread::yield();
+					std::this_thread::sleep_for(std::chrono::milliseconds(20));
+					throw std::runtime_error("late failure");
+				}
+			}, 2);
+	}
+	catch (const std::runtime_error&) { rethrown = true; }
+	assert(rethrown);
+
+	return 0;
+}
+
+double test_allocation_free_dispatch()
+{
+	std::vector<size_t> data(TEST_SIZE, 0);
+	std::atomic<size_t> sum{0};
+	auto body = [&sum](size_t& val, size_t idx) { val = idx; sum.fetch_add(1, std::memory_order_relaxed); };
+	auto compile_time = [&sum](size_t) { sum.fetch_add(1, std::memory_order_relaxed); };
 
-	async_for_each(numbers.begin(), numbers.end(),
-		[&counter](size_t& val, size_t idx)
+	// Warm up: the pool and its workers are created on first use.
+	async_for_each(data.begin(), data.end(), body);
+
+	size_t before = allocations.load();
+	for (int run = 0; run < 10; ++run)
+	{
+		async_for_each(data.begin(), data.end(), body);
+		async_for_each(dynamic_partitioner{.grain = 64}, data.begin(), data.end(), body);
+		async_for_each<size_t, 0, 256, 1>(compile_time);
+	}
+	assert(stats::enabled || allocations.load() == before); // recording calls allocates
+	assert(sum.load() == 21 * TEST_SIZE + 10 * 256);
+
+	return 0;
+}
+
+double test_thread_specific()
+{
+	const size_t n = TEST_SIZE;
+	std::vector<size_t> data(n);
+	std::iota(data.begin(), data.end(), 0);
+
+	enumerable_thread_specific<size_t> sums;
+	async_for_each(data.begin(), data.end(), [&](size_t v, size_t, size_t tid) { sums.local(tid) += v; });
+	assert(sums.combine(std::plus<>{}) == n * (n - 1) / 2);
+	assert(sums.size() >= 1 && sums.size() <= sums.slots());
+	sums.clear();
+	assert(sums.size() == 0 && sums.combine(std::plus<>{}) == 0);
+
+	enumerable_thread_specific<std::vector<size_t>> seen([] { return std::vector<size_t>{}; });
+	async_for_each(dynamic_partitioner{.grain = 16}, data.begin(), data.end(),
+		[&](size_t v, size_t, size_t tid) { seen.local(tid).push_back(v); });
+	size_t total = 0;
+	seen.combine_each([&](const std::vector<size_t>& v) { total += v.size(); });
+	assert(total == n);
+
+	enumerable_thread_specific<scratch_arena> arenas;
+	std::vector<double> out(n);
+	async_for_each(dynamic_partitioner{.grain = 16}, out.begin(), out.end(),
+		[&](double& val, size_t idx, size_t tid)
 		{
-			val = idx;
-			counter++;
+			scratch_arena& arena = arenas.local(tid);
+			auto tmp = arena.allocate<double>(8);
+			assert(reinterpret_cast<uintptr_t>(tmp.data()) % alignof(double) == 0);
+			for (size_t i = 0; i < tmp.size(); ++i)
+				tmp[i] = static_cast<double>(idx + i);
+			val = std::accumulate(tmp.begin(), tmp.end(), 0.0);
+			arena.reset();
 		});
+	for (size_t i = 0; i < n; ++i)
+		assert(out[i] == static_cast<double>(8 * i + 28));
+
+	// Overflow is served, then absorbed into the block on reset.
+	scratch_arena small(64);
+	auto big = small.allocate<char>(100);
+	auto wide = small.allocate<std::max_align_t>(3);
+	assert(big.size() == 100 && wide.size() == 3);
+	assert(reinterpret_cast<uintptr_t>(wide.data()) % alignof(std::max_align_t) == 0);
+	assert(small.used() >= 100 + 3 * sizeof(std::max_align_t));
+	small.reset();
+	assert(small.used() == 0 && small.capacity() >= 100 + 3 * sizeof(std::max_align_t));
 
-	assert(counter.load() == TEST_SIZE);
 	return 0;
 }
 
-double test_compile_time_dispatch() 
+double test_adaptive()
 {
+	// A tiny loop runs inline on the caller.
+	std::vector<size_t> small(16, 0);
+	const auto caller = std::this_thread::get_id();
+	bool inline_only = true;
+	auto tiny = [&](size_t& val, size_t idx, size_t tid)
+	{
+		val = idx;
+		inline_only = inline_only && tid == 0 && std::this_thread::get_id() == caller;
+	};
+	for (int run = 0; run < 6; ++run)
+		async_for_each(adaptive_partitioner{}, small.begin(), small.end(), tiny);
+	assert(inline_only);
+	for (size_t i = 0; i < small.size(); ++i)
+		assert(small[i] == i);
+	assert(detail::site_of<decltype(tiny)>().samples() == adaptive_partitioner{}.samples);
+
+	// So does a short list, under every policy, and a list within the minimum grain.
+	std::list<size_t> few(16, 0);
+	auto few_inline = [&](size_t& val, size_t idx, size_t tid)
+	{
+		val = idx;
+		inline_only = inline_only && tid == 0 && std::this_thread::get_id() == caller;
+	};
+	async_for_each(few.begin(), few.end(), few_inline);
+	async_for_each(guided_partitioner{}, few.begin(), few.end(), few_inline);
+	async_for_each(few, few_inline);
+	set_min_grain(64);
+	async_for_each(dynamic_partitioner{.grain = 1}, few.begin(), few.end(), few_inline);
+	set_min_grain(1);
+	assert(inline_only);
+	size_t expected_index = 0;
+	for (size_t v : few)
+		assert(v == expected_index++);
+
+	// Concurrent measurements are neither lost nor mixed up with the count.
+	detail::tuning_site site;
+	std::vector<std::thread> recorders;
+	for (size_t t = 0; t < 4; ++t)
+		recorders.emplace_back([&site, t] { for (int i = 0; i < 1000; ++i) site.record(10.0 * static_cast<double>(t + 1)); });
+	for (auto& recorder : recorders)
+		recorder.join();
+	assert(site.samples() == 4000 && std::fabs(site.cost_ns() - 25.0) < 0.01);
+
+	// A costly loop is split, and every element is still visited once with its own index.
+	std::vector<double> data(TEST_SIZE * 4, 0.0);
 	std::atomic<size_t> counter{0};
+	auto heavy = [&counter](double& val, size_t idx)
+	{
+		val = 0.0;
+		for (int i = 0; i < 100; ++i)
+			val += std::sin(static_cast<double>(idx + i));
+		counter++;
+	};
+	for (int run = 0; run < 3; ++run)
+		async_for_each(adaptive_partitioner{.samples = 2, .probe = 16}, data.begin(), data.end(), heavy);
+	assert(counter.load() == 3 * data.size());
+	for (size_t i = 0; i < data.size(); i += 97)
+	{
+		double expected = 0.0;
+		for (int k = 0; k < 100; ++k)
+			expected += std::sin(static_cast<double>(i + k));
+		assert(data[i] == expected);
+	}
 
-	async_for_each<size_t, 0, TEST_SIZE, 1>(
-		[&counter](size_t idx)
+	// The minimum grain caps the thread count, down to inline execution.
+	set_min_grain(TEST_SIZE / 2);
+	std::vector<size_t> numbers(TEST_SIZE, 0);
+	std::atomic<size_t> max_tid{0}, progress_calls{0};
+	async_for_each(numbers.begin(), numbers.end(),
+		[&](size_t&, size_t, size_t tid)
 		{
-			counter++;
+			size_t prev = max_tid.load();
+			while (tid > prev && !max_tid.compare_exchange_weak(prev, tid));
 		});
+	assert(max_tid.load() <= 1);
+	async_for_each(numbers.begin(), numbers.begin() + 100, [](size_t&) {}, runtime_threads(),
+		[&](size_t count) { progress_calls++; assert(count == 1); });
+	assert(progress_calls.load() == 1);
+	set_min_grain(1);
+	assert(min_grain() == 1);
 
-	assert(counter.load() == TEST_SIZE);
 	return 0;
 }
 
-double test_exception_handling() 
+double test_stats()
 {
+	stats& sink = stats::instance();
+	sink.clear();
+
 	std::vector<size_t> numbers(TEST_SIZE, 0);
+	async_for_each(static_partitioner{}, numbers.begin(), numbers.end(), [](size_t& val, size_t idx) { val = idx; }, 4);
+	std::list<size_t> nodes(1000, 0);
+	async_for_each(nodes.begin(), nodes.end(), [](size_t& val) { val = 1; }, 2);
 
-	try
+	std::ostringstream trace;
+	sink.write_chrome_trace(trace);
+	assert(trace.str().find("\"traceEvents\"") != std::string::npos);
+
+	auto calls = sink.calls();
+	if constexpr (!stats::enabled)
 	{
-		async_for_each(numbers.begin(), numbers.end(),
-			[](size_t& val, size_t idx)
+		assert(calls.empty());
+		return 0;
+	}
+
+	// One record per call; each participant's chunks cover its elements and the whole range is covered once.
+	assert(calls.size() == 2);
+	for (const auto& call : calls)
+	{
+		size_t expected = &call == &calls[0] ? numbers.size() : nodes.size();
+		size_t total = 0;
+		std::vector<size_t> per_participant(call.participants.size(), 0);
+		for (const auto& chunk : call.chunks)
+		{
+			assert(chunk.thread_id < call.participants.size());
+			assert(chunk.start <= chunk.end);
+			per_participant[chunk.thread_id] += chunk.count;
+			total += chunk.count;
+		}
+		assert(total == expected);
+		for (size_t i = 0; i < call.participants.size(); ++i)
+		{
+			const auto& p = call.participants[i];
+			assert(p.thread_id == i && p.elements == per_participant[i]);
+			assert(call.start <= p.start && p.start <= p.end && p.end <= call.end);
+		}
+		assert(call.imbalance() >= 1.0);
+		assert(call.overhead().count() >= 0 && call.dispatch_latency().count() >= 0);
+	}
+	assert(calls[0].participants.size() == 4 && calls[1].participants.size() == 2);
+	assert(calls[1].id == calls[0].id + 1);
+	assert(trace.str().find("\"ph\":\"X\"") != std::string::npos);
+
+	sink.clear();
+	assert(sink.calls().empty());
+
+	return 0;
+}
+
+double test_throttled_progress()
+{
+	std::vector<size_t> data(TEST_SIZE, 0);
+
+	// Reports all come from the calling thread, never decrease and end with the full count.
+	std::vector<size_t> reports;
+	const auto caller = std::this_thread::get_id();
+	bool on_caller = true;
+	auto collect = [&](size_t processed)
+	{
+		on_caller = on_caller && std::this_thread::get_id() == caller;
+		reports.push_back(processed);
+	};
+	async_for_each(data.begin(), data.end(), [](size_t& val, size_t idx) { val = idx; }, runtime_threads(),
+		throttled_progress{.callback = collect, .every = 64, .interval = std::chrono::microseconds(0)});
+	assert(reports.size() > runtime_threads() + 1);
+	assert(std::is_sorted(reports.begin(), reports.end()));
+	assert(reports.back() == data.size() && on_caller);
+	for (size_t i = 0; i < data.size(); ++i)
+		assert(data[i] == i);
+
+	// The interval throttles reports; the index and thread id still reach the body.
+	size_t calls = 0, last = 0;
+	std::atomic<size_t> max_tid{0};
+	async_for_each(dynamic_partitioner{.grain = 256}, data.begin(), data.end(),
+		[&](size_t& val, size_t idx, size_t tid)
+		{
+			val = 2 * idx;
+			size_t prev = max_tid.load();
+			while (tid > prev && !max_tid.compare_exchange_weak(prev, tid));
+		}, 4,
+		throttled_progress{[&](size_t processed) { calls++; last = processed; }, 16, std::chrono::seconds(3600)});
+	assert(calls == 1 && last == data.size());
+	assert(max_tid.load() < 4);
+	for (size_t i = 0; i < data.size(); ++i)
+		assert(data[i] == 2 * i);
+
+	// Forward ranges count node by node too; participant 0 may find the list already drained.
+	std::list<size_t> nodes(5000, 0);
+	size_t list_reports = 0, list_last = 0;
+	async_for_each(nodes.begin(), nodes.end(), [](size_t& val) { val = 1; }, 2,
+		throttled_progress{[&](size_t processed)
+		{
+			on_caller = on_caller && std::this_thread::get_id() == caller;
+			list_reports++;
+			list_last = processed;
+		}, 100, std::chrono::microseconds(0)});
+	assert(list_last == nodes.size() && list_reports >= 1 && on_caller);
+
+	return 0;
+}
+
+double test_concurrency()
+{
+	thread_pool& pool = thread_pool::instance();
+	const size_t original = runtime_threads();
+	assert(pool.size() == original);
+	assert(available_concurrency() >= 1);
+
+	// The cgroup quota is the tightest limit from the leaf up, found through the mounts.
+	namespace fs = std::filesystem;
+	const fs::path fake = fs::temp_directory_path() / "async_cgroup_test";
+	auto put = [](const fs::path& file, const std::string& text)
+	{
+		fs::create_directories(file.parent_path());
+		std::ofstream(file) << text;
+	};
+	fs::remove_all(fake);
+	put(fake / "v2proc/cgroup", "0::/kube/pod/leaf\n");
+	put(fake / "v2proc/mountinfo", "30 25 0:26 / " + (fake / "v2").string() + " rw,nosuid - cgroup2 cgroup2 rw\n");
+	put(fake / "v2/cpu.max", "max 100000\n");
+	put(fake / "v2/kube/cpu.max", "150000 100000\n");
+	put(fake / "v2/kube/pod/cpu.max", "max 100000\n");
+	put(fake / "v2/kube/pod/leaf/cpu.max", "400000 100000\n");
+	assert(detail::cgroup_quota((fake / "v2proc").string()) == 2);
+
+	put(fake / "v1proc/cgroup", "5:memory:/docker/abc\n4:cpu,cpuacct:/docker/abc\n");
+	put(fake / "v1proc/mountinfo",
+		"31 25 0:27 /docker/abc " + (fake / "v1").string() + " rw - cgroup cgroup rw,cpu,cpuacct\n"
+		"32 25 0:28 /docker/abc " + (fake / "mem").string() + " rw - cgroup cgroup rw,memory\n");
+	put(fake / "v1/cpu.cfs_quota_us", "250000\n");
+	put(fake / "v1/cpu.cfs_period_us", "100000\n");
+	assert(detail::cgroup_quota((fake / "v1proc").string()) == 3);
+	assert(detail::cgroup_quota((fake / "missing").string()) == 0);
+	fs::remove_all(fake);
+
+	auto check = [](size_t threads)
+	{
+		std::vector<size_t> data(TEST_SIZE, 0);
+		std::atomic<size_t> max_tid{0};
+		async_for_each(dynamic_partitioner{.grain = 16}, data.begin(), data.end(),
+			[&](size_t& val, size_t idx, size_t tid)
 			{
-				if (idx == TEST_SIZE / 2)
-				{
-					throw std::runtime_error("test exception");
-				}
 				val = idx;
+				size_t prev = max_tid.load();
+				while (tid > prev && !max_tid.compare_exchange_weak(prev, tid));
 			});
-		assert(false && "Expected exception was not thrown");
+		assert(max_tid.load() < threads);
+		for (size_t i = 0; i < data.size(); ++i)
+			assert(data[i] == i);
+	};
+
+	// Shrinking and growing change the default thread count and the workers.
+	set_concurrency(2);
+	assert(runtime_threads() == 2 && pool.size() == 2);
+	check(2);
+
+	set_concurrency(6);
+	assert(runtime_threads() == 6 && pool.size() == 6);
+	check(6);
+	assert(pool.submit_to(5, [] { return thread_pool::instance().worker_index(); }).get() == 5);
+
+	// Work queued on a retiring worker still runs.
+	std::atomic<bool> release{false};
+	auto blocker = pool.submit_to(5, [&release] { while (!release.load()) std::this_thread::yield(); });
+	auto queued = pool.submit_to(5, [] { return 7; });
+	std::thread releaser([&release] { std::this_thread::sleep_for(std::chrono::milliseconds(10)); release = true; });
+	set_concurrency(2);
+	releaser.join();
+	assert(queued.get() == 7);
+	blocker.get();
+	assert(pool.size() == 2);
+	check(2);
+
+	// Resizing from inside the pool is refused.
+	bool refused = pool.submit([&pool]
+	{
+		try { pool.resize(3); }
+		catch (const std::logic_error&) { return true; }
+		return false;
+	}).get();
+	assert(refused && pool.size() == 2);
+
+	// 0 re-reads the affinity mask and CPU quota.
+	set_concurrency(0);
+	assert(runtime_threads() == std::clamp<size_t>(available_concurrency(), ASYNC_MIN_THREADS, ASYNC_MAX_THREADS));
+	check(runtime_threads());
+
+	set_concurrency(original);
+	assert(runtime_threads() == original && pool.size() == original);
+
+	return 0;
+}
+
+double test_multidimensional()
+{
+	// Every (i, j) is visited once, including the partial edge tiles.
+	const size_t rows = 67, cols = 45;
+	std::vector<std::atomic<int>> grid(rows * cols);
+	std::atomic<size_t> max_tid{0};
+	async_for_each_2d(rows, cols, [&](size_t i, size_t j, size_t tid)
+		{
+			grid[i * cols + j]++;
+			size_t prev = max_tid.load();
+			while (tid > prev && !max_tid.compare_exchange_weak(prev, tid));
+		}, tile_2d{.rows = 16, .cols = 8});
+	for (const auto& g : grid)
+		assert(g.load() == 1);
+	assert(max_tid.load() < runtime_threads());
+
+	// A 5-point stencil with dynamically claimed tiles.
+	std::vector<double> in(rows * cols), out(rows * cols, 0.0);
+	std::iota(in.begin(), in.end(), 0.0);
+	async_for_each_2d(dynamic_partitioner{.grain = 2}, rows - 2, cols - 2, [&](size_t i, size_t j)
+		{
+			size_t c = (i + 1) * cols + (j + 1);
+			out[c] = in[c] + in[c - 1] + in[c + 1] + in[c - cols] + in[c + cols];
+		});
+	for (size_t i = 1; i + 1 < rows; ++i)
+		for (size_t j = 1; j + 1 < cols; ++j)
+			assert(out[i * cols + j] == 5 * in[i * cols + j]);
+
+	// 3D, with a tile larger than the space and an empty space.
+	const size_t depth = 5, height = 7, width = 9;
+	std::vector<std::atomic<int>> volume(depth * height * width);
+	async_for_each_3d(guided_partitioner{}, depth, height, width, [&](size_t i, size_t j, size_t k)
+		{
+			volume[(i * height + j) * width + k]++;
+		}, tile_3d{.depth = 2, .rows = 100, .cols = 4});
+	for (const auto& v : volume)
+		assert(v.load() == 1);
+	async_for_each_2d(0, cols, [](size_t, size_t) { assert(false); });
+
+	// Compile-time extents and tiles.
+	std::vector<std::atomic<int>> fixed(10 * 12);
+	async_for_each_2d<10, 12, 4, 8>([&](size_t i, size_t j, size_t tid)
+		{
+			assert(tid < async::threads);
+			fixed[i * 12 + j]++;
+		});
+	for (const auto& f : fixed)
+		assert(f.load() == 1);
+
+	std::vector<std::atomic<int>> fixed3(3 * 4 * 5);
+	async_for_each_3d<3, 4, 5, 2, 2, 2>([&](size_t i, size_t j, size_t k) { fixed3[(i * 4 + j) * 5 + k]++; });
+	for (const auto& f : fixed3)
+		assert(f.load() == 1);
+
+	// More chunks than tiles leaves the extra chunks empty.
+	std::atomic<size_t> visits{0};
+	async_for_each_2d<2, 2, 2, 1, 4>([&](size_t, size_t) { visits++; });
+	assert(visits.load() == 4);
+	visits = 0;
+	async_for_each_2d<5, 1, 1, 1, 4>([&](size_t, size_t) { visits++; });
+	async_for_each<size_t, 0, 5, 1, 4>([&](size_t) { visits++; });
+	assert(visits.load() == 10);
+
+	return 0;
+}
+
+double test_ranges()
+{
+	const size_t n = TEST_SIZE;
+	std::vector<double> a(n), b(n, 2.0), c(n, 0.0);
+	std::iota(a.begin(), a.end(), 0.0);
+
+	// Containers and views are taken whole.
+	async_for_each(c, [](double& x, size_t idx) { x = static_cast<double>(idx); });
+	for (size_t i = 0; i < n; ++i)
+		assert(c[i] == a[i]);
+
+	std::vector<std::atomic<int>> hits(n);
+	async_for_each(dynamic_partitioner{.grain = 32}, std::views::iota(size_t{0}, n), [&](size_t i) { hits[i]++; });
+	async_for_each(std::views::iota(size_t{0}) | std::views::take(n), [&](size_t i, size_t idx) { assert(i == idx); hits[i]++; });
+	for (const auto& h : hits)
+		assert(h.load() == 2);
+
+	// Tuple elements are unpacked into references, with or without index and thread id.
+	auto soa = std::views::iota(size_t{0}, n) 
+		| std::views::transform([&](size_t i) { return std::tuple<double&, double&, double&>(a[i], b[i], c[i]); });
+	async_for_each(soa, [](double& x, double& y, double& z) { z = x * y; });
+	for (size_t i = 0; i < n; ++i)
+		assert(c[i] == 2.0 * a[i]);
+	async_for_each(guided_partitioner{}, soa, [](double& x, double&, double& z, size_t idx, size_t tid)
+		{
+			assert(x == static_cast<double>(idx));
+			assert(tid < runtime_threads());
+			z = x + 1.0;
+		});
+	for (size_t i = 0; i < n; ++i)
+		assert(c[i] == a[i] + 1.0);
+
+	// A body taking the tuple itself gets it whole.
+	std::atomic<size_t> whole{0};
+	async_for_each(soa, [&](std::tuple<double&, double&, double&> t) { whole += std::get<1>(t) == 2.0; });
+	assert(whole.load() == n);
+
+#if defined(__cpp_lib_ranges_zip)
+	async_for_each(std::views::zip(a, b, c), [](double& x, double& y, double& z) { z = x - y; });
+	for (size_t i = 0; i < n; ++i)
+		assert(c[i] == a[i] - 2.0);
+#endif
+
+	// Forward-only views still work.
+	std::list<int> nodes(1000, 1);
+	std::atomic<int> sum{0};
+	async_for_each(nodes | std::views::transform([](int v) { return 2 * v; }), [&](int v) { sum += v; });
+	assert(sum.load() == 2000);
+
+	// Non-common forward views run to their sentinel, with exact indices.
+	std::list<size_t> numbered(1000);
+	std::iota(numbered.begin(), numbered.end(), size_t{0});
+	auto head = numbered | std::views::take(700);
+	static_assert(!std::ranges::common_range<decltype(head)>);
+	std::vector<std::atomic<int>> seen(1000);
+	async_for_each(dynamic_partitioner{.grain = 64}, head, [&](size_t v, size_t idx) { assert(v == idx); seen[v]++; });
+	for (size_t i = 0; i < seen.size(); ++i)
+		assert(seen[i].load() == (i < 700 ? 1 : 0));
+
+	return 0;
+}
+
+double test_uneven_chunks()
+{
+	// Sizes that do not divide by the thread count still get each element's own index.
+	for (size_t n : {size_t{7}, size_t{1023}, size_t{TEST_SIZE + 3}})
+	{
+		std::vector<size_t> data(n, 0);
+		async_for_each(data.begin(), data.end(), [](size_t& val, size_t idx) { val = idx; }, 4);
+		for (size_t i = 0; i < n; ++i)
+			assert(data[i] == i);
+
+		// Balanced chunks differ by at most one element and start with the longer ones.
+		std::vector<std::atomic<size_t>> per_thread(4);
+		std::fill(data.begin(), data.end(), 0);
+		async_for_each(static_partitioner{.balanced = true}, data.begin(), data.end(),
+			[&](size_t& val, size_t idx, size_t tid) { val = idx; per_thread[tid]++; }, 4);
+		for (size_t i = 0; i < n; ++i)
+			assert(data[i] == i);
+		for (size_t t = 0; t < 4; ++t)
+			assert(per_thread[t].load() == n / 4 + (t < n % 4 ? 1 : 0));
 	}
-	catch (const std::runtime_error& e)
+
+	// The balanced split also applies to partitioned algorithms.
+	std::vector<size_t> values(TEST_SIZE + 1);
+	std::iota(values.begin(), values.end(), 0);
+	size_t sum = async_reduce(static_partitioner{.balanced = true}, values.begin(), values.end(), size_t{0});
+	assert(sum == TEST_SIZE * (TEST_SIZE + 1) / 2);
+
+	return 0;
+}
+
+double test_caller_participates()
+{
+	// Chunk 0 runs on the calling thread; the others are queued, and the joining caller may help with them.
+	std::vector<size_t> data(TEST_SIZE, 0);
+	const auto caller = std::this_thread::get_id();
+	std::atomic<bool> first_on_caller{false};
+	async_for_each(data.begin(), data.end(), [&](size_t& val, size_t idx, size_t tid)
+		{
+			val = idx;
+			if (tid == 0 && std::this_thread::get_id() == caller) first_on_caller = true;
+		}, 4);
+	assert(first_on_caller.load());
+
+	// Many short loops complete through the spin-then-park join, nested ones included.
+	std::atomic<size_t> total{0};
+	for (int run = 0; run < 2000; ++run)
+		async_for_each(data.begin(), data.begin() + 64, [&](size_t&) { total.fetch_add(1, std::memory_order_relaxed); });
+	assert(total.load() == 2000 * 64);
+
+	total = 0;
+	async_for_each(data.begin(), data.begin() + 8, [&](size_t&)
+		{
+			async_for_each(data.begin(), data.begin() + 8, [&](size_t&) { total.fetch_add(1, std::memory_order_relaxed); });
+		});
+	assert(total.load() == 64);
+
+	return 0;
+}
+
+double test_errors()
+{
+	// Aggregate mode runs every element and reports each failure by index.
+	std::vector<size_t> data(TEST_SIZE, 0);
+	auto check_aggregate = [&](auto part)
 	{
-		std::cout << "Caught expected exception: " << e.what() << std::endl;
+		std::atomic<size_t> visited{0};
+		auto errors = async_for_each(aggregate_errors, part, data.begin(), data.end(), [&](size_t&, size_t idx)
+			{
+				visited.fetch_add(1, std::memory_order_relaxed);
+				if (idx % 1000 == 7) throw std::runtime_error(std::to_string(idx));
+			});
+		assert(visited.load() == TEST_SIZE);
+		assert(errors.size() == (TEST_SIZE + 992) / 1000);
+		for (size_t i = 0; i < errors.size(); ++i)
+		{
+			assert(errors[i].first == i * 1000 + 7);
+			try { std::rethrow_exception(errors[i].second); }
+			catch (const std::runtime_error& e) { assert(e.what() == std::to_string(errors[i].first)); }
+		}
+	};
+	check_aggregate(static_partitioner{});
+	check_aggregate(dynamic_partitioner{.grain = 100});
+	check_aggregate(guided_partitioner{});
+	check_aggregate(stealing_partitioner{});
+	check_aggregate(adaptive_partitioner{});
+
+	std::list<size_t> nodes(1000, 0);
+	auto list_errors = async_for_each(aggregate_errors, nodes.begin(), nodes.end(), [](size_t&, size_t idx)
+		{
+			if (idx >= 990) throw std::logic_error("tail");
+		});
+	assert(list_errors.size() == 10 && list_errors.front().first == 990 && list_errors.back().first == 999);
+	assert(async_for_each(aggregate_errors, data.begin(), data.end(), [](size_t& val) { val = 1; }).empty());
+
+	// The default mode still rethrows the first failure from concurrent throwers.
+	for (int run = 0; run < 50; ++run)
+	{
+		bool caught = false;
+		try
+		{
+			async_for_each(data.begin(), data.end(), [](size_t&, size_t idx)
+				{
+					if (idx % 64 == 0) throw std::runtime_error("fail");
+				}, 4);
+		}
+		catch (const std::runtime_error&) { caught = true; }
+		assert(caught);
 	}
 
-	return 0.0;
+	// A noexcept body takes the fast path and still visits everything.
+	static_assert(detail::nothrow_body_v<void (&)(size_t&) noexcept, size_t&>);
+	static_assert(!detail::nothrow_body_v<void (&)(size_t&, size_t), size_t&>);
+	std::fill(data.begin(), data.end(), 0);
+	async_for_each(data.begin(), data.end(), [](size_t& val, size_t idx) noexcept { val = idx; });
+	async_for_each(dynamic_partitioner{}, data.begin(), data.end(), [](size_t& val) noexcept { ++val; });
+	for (size_t i = 0; i < TEST_SIZE; ++i)
+		assert(data[i] == i + 1);
+
+	// Without the participants' try, a throwing progress callback still reaches the caller.
+	auto throws_from_progress = [&](auto run)
+	{
+		bool thrown = false;
+		try { run([](size_t) { throw std::logic_error("progress"); }); }
+		catch (const std::logic_error&) { thrown = true; }
+		return thrown;
+	};
+	auto bump = [](size_t& val) noexcept { ++val; };
+	assert(throws_from_progress([&](auto p) { async_for_each(data.begin(), data.end(), bump, 4, p); }));
+	assert(throws_from_progress([&](auto p) { async_for_each(dynamic_partitioner{.grain = 64}, data.begin(), data.end(), bump, 4, p); }));
+	assert(throws_from_progress([&](auto p) { async_for_each(guided_partitioner{}, data.begin(), data.end(), bump, 4, p); }));
+	assert(throws_from_progress([&](auto p) { async_for_each(stealing_partitioner{}, data.begin(), data.end(), bump, 4, p); }));
+	std::list<size_t> noexcept_nodes(1000, 0);
+	assert(throws_from_progress([&](auto p) { async_for_each(noexcept_nodes.begin(), noexcept_nodes.end(), bump, 4, p); }));
+
+	// Noexcept bodies run everywhere: partitioned, launched and over lists. The list
+	// loop above ran every node despite the abort, since noexcept loops do not poll it.
+	std::fill(data.begin(), data.end(), 0);
+	async_for_each(stealing_partitioner{}, data.begin(), data.end(), bump);
+	async_launch_for_each(guided_partitioner{}, data.begin(), data.end(), bump).wait();
+	async_for_each(noexcept_nodes.begin(), noexcept_nodes.end(), bump);
+	assert(std::all_of(data.begin(), data.end(), [](size_t v) { return v == 2; }));
+	assert(std::all_of(noexcept_nodes.begin(), noexcept_nodes.end(), [](size_t v) { return v == 2; }));
+
+	return 0;
+}
+
+double test_priority_submit()
+{
+	// Results, void tasks, move-only results and exceptions.
+	auto doubled = submit(priority::high, [](int x) { return 2 * x; }, 21);
+	assert(doubled.valid() && doubled.get() == 42 && !doubled.valid());
+
+	std::atomic<bool> ran{false};
+	auto done = submit(priority::low, [&] { ran = true; });
+	done.wait();
+	assert(done.is_ready() && ran.load());
+	done.get();
+
+	auto boxed = submit(priority::normal, [] { return std::make_unique<int>(7); });
+	assert(*boxed.get() == 7);
+
+	auto failed = submit(priority::high, []() -> int { throw std::runtime_error("fail"); });
+	bool caught = false;
+	try { failed.get(); }
+	catch (const std::runtime_error&) { caught = true; }
+	assert(caught);
+
+	// Dropping a future does not wait, and the task still runs.
+	std::atomic<bool> detached{false};
+	submit(priority::low, [&] { detached = true; });
+	while (!detached.load())
+		std::this_thread::yield();
+
+	// With the only worker busy, queued work runs high, private, normal, then low.
+	thread_pool pool(1);
+	std::atomic<bool> started{false}, release{false};
+	std::mutex order_mutex;
+	std::vector<char> order;
+	auto record = [&](char c) { std::lock_guard<std::mutex> lock(order_mutex); order.push_back(c); };
+
+	auto blocker = pool.submit([&] { started = true; while (!release.load()) std::this_thread::yield(); });
+	while (!started.load())
+		std::this_thread::yield();
+
+	auto normal = pool.submit([&] { record('n'); });
+	auto low = pool.submit(priority::low, [&] { record('l'); });
+	auto local = pool.submit_to(0, [&] { record('p'); });
+	auto high = pool.submit(priority::high, [&] { record('h'); });
+	release = true;
+
+	while (!low.is_ready())
+		std::this_thread::yield();
+	assert((order == std::vector<char>{'h', 'p', 'n', 'l'}));
+	blocker.get(); normal.get(); local.get(); high.get(); low.get();
+
+	// Workers busy with a loop run a high-priority task between ranges, before the loop drains.
+	std::atomic<size_t> processed{0};
+	std::vector<size_t> data(64, 0);
+	auto loop = async_launch_for_each(dynamic_partitioner{.grain = 1}, data.begin(), data.end(), [&](size_t& val)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			val = 1;
+			processed.fetch_add(1, std::memory_order_relaxed);
+		});
+	auto urgent = submit(priority::high, [&] { return processed.load(); });
+	while (!urgent.is_ready())
+		std::this_thread::yield(); // not get(), which could run the task on this thread
+	assert(urgent.get() < data.size());
+	loop.wait();
+
+	return 0;
 }
 
 // TBB equivalent tests
@@ -171,6 +1672,70 @@ double test_async_computational_work()
 	return 0;
 }
 
+// Shared by the list benchmarks, allocated before timing.
+static std::list<double>& work_list()
+{
+	static std::list<double> list(TEST_SIZE);
+	return list;
+}
+
+double test_list_computational_work()
+{
+	std::list<double>& list = work_list();
+	std::atomic<size_t> counter{0};
+
+	async_for_each(list.begin(), list.end(),
+		[&counter](double& val, size_t idx) {
+			val = 0.0;
+			for (int i = 0; i < 100; ++i) {
+				val += std::sin(static_cast<double>(idx + i));
+			}
+			counter++;
+		});
+
+	assert(counter.load() == TEST_SIZE);
+	return 0;
+}
+
+double test_list_copy_computational_work()
+{
+	std::list<double>& list = work_list();
+	std::vector<double> data(list.begin(), list.end());
+	std::atomic<size_t> counter{0};
+
+	async_for_each(data.begin(), data.end(),
+		[&counter](double& val, size_t idx) {
+			val = 0.0;
+			for (int i = 0; i < 100; ++i) {
+				val += std::sin(static_cast<double>(idx + i));
+			}
+			counter++;
+		});
+	std::copy(data.begin(), data.end(), list.begin());
+
+	assert(counter.load() == TEST_SIZE);
+	return 0;
+}
+
+double test_stealing_computational_work()
+{
+	std::vector<double> data(TEST_SIZE);
+	std::atomic<size_t> counter{0};
+
+	async_for_each(stealing_partitioner{}, data.begin(), data.end(),
+		[&counter](double& val, size_t idx) {
+			// Simulate some computational work
+			val = 0.0;
+			for (int i = 0; i < 100; ++i) {
+				val += std::sin(static_cast<double>(idx + i));
+			}
+			counter++;
+		});
+
+	assert(counter.load() == TEST_SIZE);
+	return 0;
+}
+
 double test_tbb_computational_work()
 {
 	std::vector<double> data(TEST_SIZE);
@@ -248,6 +1813,19 @@ int main(int argc, char* argv[])
 		time = dispatch(test_async_computational_work, result, NUM_RUNS);
 		std::cout << "[ASYNC] computational_work: " << time << " s (avg)" << std::endl;
 		double async_compute_time = time;
+
+		time = dispatch(test_stealing_computational_work, result, NUM_RUNS);
+		std::cout << "[ASYNC] stealing_computational_work: " << time << " s (avg)" << std::endl;
+		double async_stealing_time = time;
+
+		work_list();
+		time = dispatch(test_list_computational_work, result, NUM_RUNS);
+		std::cout << "[ASYNC] list_computational_work: " << time << " s (avg)" << std::endl;
+		double async_list_time = time;
+
+		time = dispatch(test_list_copy_computational_work, result, NUM_RUNS);
+		std::cout << "[ASYNC] list_copy_computational_work: " << time << " s (avg)" << std::endl;
+		double async_list_copy_time = time;
 		std::cout << std::endl;
 
 		// TBB tests
@@ -277,12 +1855,95 @@ int main(int argc, char* argv[])
 		time = dispatch(test_tbb_exception_handling, result, 1);
 		std::cout << "[TBB] exception_handling: " << time << " s" << std::endl;
 		std::cout << std::endl;
+
+		// Feature tests (single run)
+		std::cout << "Feature Tests" << std::endl;
+		std::cout << "-------------" << std::endl;
+
+		time = dispatch(test_thread_pool_reuse, result, 1);
+		std::cout << "[ASYNC] thread_pool_reuse: " << time << " s" << std::endl;
+
+		time = dispatch(test_work_stealing, result, 1);
+		std::cout << "[ASYNC] work_stealing: " << time << " s" << std::endl;
+
+		time = dispatch(test_partitioners, result, 1);
+		std::cout << "[ASYNC] partitioners: " << time << " s" << std::endl;
+
+		time = dispatch(test_reduce, result, 1);
+		std::cout << "[ASYNC] reduce: " << time << " s" << std::endl;
+
+		time = dispatch(test_scan, result, 1);
+		std::cout << "[ASYNC] scan: " << time << " s" << std::endl;
+
+		time = dispatch(test_chunk_dispatch, result, 1);
+		std::cout << "[ASYNC] chunk_dispatch: " << time << " s" << std::endl;
+
+		time = dispatch(test_compile_time_indices, result, 1);
+		std::cout << "[ASYNC] compile_time_indices: " << time << " s" << std::endl;
+
+		time = dispatch(test_tiled_dispatch, result, 1);
+		std::cout << "[ASYNC] tiled_dispatch: " << time << " s" << std::endl;
+
+		time = dispatch(test_numa, result, 1);
+		std::cout << "[ASYNC] numa: " << time << " s" << std::endl;
+
+		time = dispatch(test_affinity, result, 1);
+		std::cout << "[ASYNC] affinity: " << time << " s" << std::endl;
+
+		time = dispatch(test_nested_parallelism, result, 1);
+		std::cout << "[ASYNC] nested_parallelism: " << time << " s" << std::endl;
+
+		time = dispatch(test_launch_handle, result, 1);
+		std::cout << "[ASYNC] launch_handle: " << time << " s" << std::endl;
+
+		time = dispatch(test_coroutines, result, 1);
+		std::cout << "[ASYNC] coroutines: " << time << " s" << std::endl;
+
+		time = dispatch(test_task_graph, result, 1);
+		std::cout << "[ASYNC] task_graph: " << time << " s" << std::endl;
+		time = dispatch(test_pipeline, result, 1);
+		std::cout << "[ASYNC] pipeline: " << time << " s" << std::endl;
+		time = dispatch(test_forward_iterators, result, 1);
+		std::cout << "[ASYNC] forward_iterators: " << time << " s" << std::endl;
+		time = dispatch(test_algorithms, result, 1);
+		std::cout << "[ASYNC] algorithms: " << time << " s" << std::endl;
+		time = dispatch(test_cancellation, result, 1);
+		std::cout << "[ASYNC] cancellation: " << time << " s" << std::endl;
+		time = dispatch(test_allocation_free_dispatch, result, 1);
+		std::cout << "[ASYNC] allocation_free_dispatch: " << time << " s" << std::endl;
+		time = dispatch(test_thread_specific, result, 1);
+		std::cout << "[ASYNC] thread_specific: " << time << " s" << std::endl;
+		time = dispatch(test_adaptive, result, 1);
+		std::cout << "[ASYNC] adaptive: " << time << " s" << std::endl;
+		time = dispatch(test_stats, result, 1);
+		std::cout << "[ASYNC] stats: " << time << " s" << std::endl;
+		time = dispatch(test_throttled_progress, result, 1);
+		std::cout << "[ASYNC] throttled_progress: " << time << " s" << std::endl;
+		time = dispatch(test_concurrency, result, 1);
+		std::cout << "[ASYNC] concurrency: " << time << " s" << std::endl;
+		time = dispatch(test_multidimensional, result, 1);
+		std::cout << "[ASYNC] multidimensional: " << time << " s" << std::endl;
+		time = dispatch(test_ranges, result, 1);
+		std::cout << "[ASYNC] ranges: " << time << " s" << std::endl;
+		time = dispatch(test_uneven_chunks, result, 1);
+		std::cout << "[ASYNC] uneven_chunks: " << time << " s" << std::endl;
+		time = dispatch(test_caller_participates, result, 1);
+		std::cout << "[ASYNC] caller_participates: " << time << " s" << std::endl;
+
+		time = dispatch(test_errors, result, 1);
+		std::cout << "[ASYNC] errors: " << time << " s" << std::endl;
+
+		time = dispatch(test_priority_submit, result, 1);
+		std::cout << "[ASYNC] priority_submit: " << time << " s" << std::endl;
+		std::cout << std::endl;
 		// Performance comparison
 		std::cout << "Performance Ratios (async/TBB) " << std::endl;
 		std::cout << "----------------------------------" << std::endl;
 		std::cout << "Dynamic vs Blocked Range: " << (async_dynamic_time / tbb_blocked_time) << std::endl;
 		std::cout << "Compile-time vs Simple Range: " << (async_compile_time / tbb_simple_time) << std::endl;
 		std::cout << "Computational Work: " << (async_compute_time / tbb_compute_time) << std::endl;
+		std::cout << "Stealing Computational Work: " << (async_stealing_time / tbb_compute_time) << std::endl;
+		std::cout << "List vs Vector Copy: " << (async_list_time / async_list_copy_time) << std::endl;
 		std::cout << std::endl;
 
 		std::cout << "Summary" << std::endl;